@@ -0,0 +1,39 @@
+#include "arena.h"
+
+#include <algorithm>
+
+Arena::Arena(size_t blockSize) : blockSize(blockSize) {}
+
+// Procura espaço no bloco atual e nos seguintes (já alocados em usos anteriores da arena) antes de alocar um novo bloco.
+// Uma alocação maior que o tamanho padrão ganha um bloco só para ela
+void* Arena::allocate(size_t size, size_t align) {
+    while (current < blocks.size()) {
+        Block& block = blocks[current];
+        size_t start = (offset + align - 1) & ~(align - 1);
+        if (start + size <= block.size) {
+            offset = start + size;
+            used += size;
+            return block.data.get() + start;
+        }
+        ++current;
+        offset = 0;
+    }
+    size_t newSize = std::max(blockSize, size + align);
+    blocks.push_back({ std::make_unique<char[]>(newSize), newSize });
+    current = blocks.size() - 1;
+    offset = 0;
+    return allocate(size, align);
+}
+
+std::string_view Arena::copy(std::string_view data) {
+    if (data.empty()) return {};
+    char* out = static_cast<char*>(allocate(data.size(), 1));
+    std::memcpy(out, data.data(), data.size());
+    return std::string_view(out, data.size());
+}
+
+void Arena::reset() {
+    current = 0;
+    offset = 0;
+    used = 0;
+}
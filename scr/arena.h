@@ -0,0 +1,52 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <memory>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include <cstddef>
+#include <cstring>
+
+
+// Alocador por incremento de ponteiro ("bump allocator"): cada alocação apenas avança a posição no bloco atual,
+// e tudo o que foi alocado é liberado de uma vez com "reset", em O(1). Os blocos são mantidos para o próximo uso,
+// então uma arena reaproveitada não volta a chamar o alocador do sistema depois de atingir o seu tamanho de trabalho.
+// Apenas tipos trivialmente destrutíveis podem ser alocados, pois nenhum destrutor é chamado.
+class Arena {
+public:
+    // Cria a arena sem nenhum bloco; o primeiro é alocado no primeiro uso, com pelo menos "blockSize" bytes
+    explicit Arena(size_t blockSize = 64 * 1024);
+
+    // Aloca "size" bytes alinhados em "align" (potência de 2)
+    void* allocate(size_t size, size_t align);
+    // Aloca um vetor de "count" elementos inicializados com o valor padrão
+    template <typename T>
+    T* allocateArray(size_t count) {
+        static_assert(std::is_trivially_destructible_v<T>, "A arena não chama destrutores");
+        T* items = static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+        for (size_t i = 0; i < count; ++i) new (items + i) T();
+        return items;
+    }
+    // Copia os dados para a arena e retorna a cópia
+    std::string_view copy(std::string_view data);
+    // Libera todas as alocações, mantendo os blocos
+    void reset();
+    // Bytes alocados desde o último "reset" (sem as sobras no fim dos blocos)
+    size_t bytesUsed() const { return used; }
+
+private:
+    struct Block {
+        std::unique_ptr<char[]> data;
+        size_t size;
+    };
+
+    size_t blockSize;
+    std::vector<Block> blocks;
+    // Bloco atual e posição livre dentro dele
+    size_t current = 0;
+    size_t offset = 0;
+    size_t used = 0;
+};
+
+#endif
@@ -0,0 +1,61 @@
+#include "async_transport.h"
+
+#include "log.h"
+#include "metrics.h"
+
+// Limite de mensagens na fila de um destino. Acima dele o destino é considerado inalcançável e os envios falham
+const size_t MAX_QUEUED_PER_CHANNEL = 65536;
+
+AsyncTransport::AsyncTransport(const std::string& owner, Transport& inner, Executor& executor)
+    : owner(owner), inner(inner), executor(executor) {}
+
+AsyncTransport::Channel& AsyncTransport::channelFor(int port) {
+    std::lock_guard<std::mutex> lock(channelsMtx);
+    std::unique_ptr<Channel>& channel = channels[port];
+    if (!channel) channel = std::make_unique<Channel>();
+    return *channel;
+}
+
+// Só agenda uma tarefa quando a fila não está sendo esvaziada, para que haja no máximo uma por destino
+bool AsyncTransport::send(int port, std::string_view data) {
+    Channel& channel = channelFor(port);
+    {
+        std::lock_guard<std::mutex> lock(channel.mtx);
+        if (channel.queue.size() >= MAX_QUEUED_PER_CHANNEL) return false;
+        channel.queue.push_back(Pending{ std::string(data), std::chrono::steady_clock::now() });
+        if (channel.draining) return true;
+        channel.draining = true;
+    }
+    executor.submit([this, port, &channel] { drain(port, channel); });
+    return true;
+}
+
+bool AsyncTransport::listen(int port, const MessageHandler& handler) {
+    return inner.listen(port, handler);
+}
+
+// Retira de uma vez todas as mensagens já enfileiradas e as envia sem o lock da fila, para que novos envios não esperem.
+// Se chegaram mensagens durante o lote, a tarefa é reagendada em vez de continuar, liberando a thread para outros destinos
+void AsyncTransport::drain(int port, Channel& channel) {
+    std::deque<Pending> batch;
+    {
+        std::lock_guard<std::mutex> lock(channel.mtx);
+        batch.swap(channel.queue);
+    }
+    size_t failures = 0;
+    for (const Pending& pending : batch) {
+        record(Histogram::SEND_QUEUE_NS, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - pending.queuedAt).count());
+        if (!inner.send(port, pending.data)) ++failures;
+    }
+    if (failures > 0) {
+        LOG_WARN("[" << owner << "] Falha ao enviar " << failures << " mensagem(ns) para a porta " << port);
+    }
+    {
+        std::lock_guard<std::mutex> lock(channel.mtx);
+        if (channel.queue.empty()) {
+            channel.draining = false;
+            return;
+        }
+    }
+    executor.submit([this, port, &channel] { drain(port, channel); });
+}
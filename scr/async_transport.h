@@ -0,0 +1,58 @@
+#ifndef ASYNC_TRANSPORT_H
+#define ASYNC_TRANSPORT_H
+
+#include <string>
+#include <string_view>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <chrono>
+
+#include "transport.h"
+#include "executor.h"
+
+
+// Envios assíncronos sobre outro transporte: "send" apenas copia a mensagem para a fila do destino e retorna,
+// e as filas são esvaziadas pelas threads de um Executor. Assim quem envia (por exemplo, um filósofo com o lock
+// do seu estado adquirido) nunca espera pela rede, e um destino lento atrasa apenas as mensagens destinadas a ele.
+// Cada destino é esvaziado por no máximo uma tarefa de cada vez, então as mensagens para o mesmo destino saem
+// na ordem em que foram enviadas (os canais continuam FIFO, como exige o algoritmo de snapshot).
+class AsyncTransport : public Transport {
+public:
+    // "inner" faz os envios de fato e as escutas; "owner" identifica o dono nas mensagens impressas
+    AsyncTransport(const std::string& owner, Transport& inner, Executor& executor);
+
+    // Coloca a mensagem na fila do destino. Só retorna falso se a fila estiver cheia; as falhas do envio em si são registradas no log
+    bool send(int port, std::string_view data) override;
+    // Escuta pelo transporte interno
+    bool listen(int port, const MessageHandler& handler) override;
+
+private:
+    // Mensagem na fila, com o instante em que foi enviada
+    struct Pending {
+        std::string data;
+        std::chrono::steady_clock::time_point queuedAt;
+    };
+    // Fila de um destino
+    struct Channel {
+        std::mutex mtx;
+        std::deque<Pending> queue;
+        // Existe uma tarefa agendada ou em execução esvaziando a fila
+        bool draining = false;
+    };
+
+    std::string owner;
+    Transport& inner;
+    Executor& executor;
+    // Protege apenas o mapa de destinos
+    std::mutex channelsMtx;
+    std::map<int, std::unique_ptr<Channel>> channels;
+
+    // Retorna (criando se necessário) a fila do destino
+    Channel& channelFor(int port);
+    // Envia um lote de mensagens da fila do destino e reagenda a tarefa se ainda restarem mensagens
+    void drain(int port, Channel& channel);
+};
+
+#endif
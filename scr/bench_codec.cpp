@@ -0,0 +1,197 @@
+// Microbenchmark do formato binário de Message e Snapshot contra o formato de texto anterior
+// ("tipo|remetente|conteúdo" e "chave=valor;"), reproduzido aqui apenas para comparação, e da decodificação
+// dos snapshots pelo coordenador em uma arena.
+//
+// Uso: ./bench_codec [iterações]
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "message.h"
+#include "snapshot.h"
+
+namespace legacy {
+
+struct Message {
+    int type;
+    int senderId;
+    std::string content;
+
+    std::string serialize() const {
+        return std::to_string(type) + "|" + std::to_string(senderId) + "|" + content;
+    }
+
+    static Message deserialize(const std::string& data) {
+        std::stringstream ss(data);
+        std::string part;
+        Message msg;
+        std::getline(ss, part, '|');
+        msg.type = std::stoi(part);
+        std::getline(ss, part, '|');
+        msg.senderId = std::stoi(part);
+        if (!std::getline(ss, msg.content)) msg.content = "";
+        return msg;
+    }
+};
+
+struct Snapshot {
+    std::string localState;
+    std::map<int, std::vector<std::string>> channelMessages;
+    bool hasLeftFork = false;
+    bool hasRightFork = false;
+    int leftForkId;
+    int rightForkId;
+
+    std::string serialize() const {
+        std::ostringstream oss;
+        oss << "state=" << localState;
+        oss << ";hasLeft=" << (hasLeftFork ? "true" : "false");
+        oss << ";hasRight=" << (hasRightFork ? "true" : "false");
+        oss << ";leftForkId=" << leftForkId;
+        oss << ";rightForkId=" << rightForkId;
+        for (const auto& [from, msgs] : channelMessages) {
+            for (const std::string& msg : msgs) {
+                oss << ";channel_from_" << from << "_msg_" << msg;
+            }
+        }
+        return oss.str();
+    }
+
+    static Snapshot deserialize(const std::string& data) {
+        Snapshot snap;
+        std::string token;
+        std::istringstream iss(data);
+        while (std::getline(iss, token, ';')) {
+            size_t eqPos = token.find('=');
+            if (eqPos == std::string::npos) {
+                size_t fromPos = token.find("channel_from_");
+                if (fromPos != std::string::npos) {
+                    std::string rest = token.substr(fromPos + strlen("channel_from_"));
+                    size_t msgPos = rest.find("_msg_");
+                    if (msgPos != std::string::npos) {
+                        int senderId = std::stoi(rest.substr(0, msgPos));
+                        snap.channelMessages[senderId].push_back(rest.substr(msgPos + strlen("_msg_")));
+                    }
+                }
+                continue;
+            }
+            std::string key = token.substr(0, eqPos);
+            std::string value = token.substr(eqPos + 1);
+            if (key == "state") snap.localState = value;
+            else if (key == "hasLeft") snap.hasLeftFork = (value == "true");
+            else if (key == "hasRight") snap.hasRightFork = (value == "true");
+            else if (key == "leftForkId") snap.leftForkId = std::stoi(value);
+            else if (key == "rightForkId") snap.rightForkId = std::stoi(value);
+        }
+        return snap;
+    }
+};
+
+} // namespace legacy
+
+// Impede que o compilador descarte os resultados calculados
+static volatile long long sink = 0;
+
+// Executa "body" "iterations" vezes e imprime o tempo médio por iteração
+template <typename Body>
+static double measure(const char* name, long iterations, Body body) {
+    auto begin = std::chrono::steady_clock::now();
+    for (long i = 0; i < iterations; ++i) body(i);
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+    double perOp = elapsed / iterations;
+    std::cout << "  " << name << ": " << perOp << " ns/op\n";
+    return perOp;
+}
+
+int main(int argc, char* argv[]) {
+    long iterations = argc > 1 ? std::stol(argv[1]) : 1000000;
+    const int channels = 4;
+    const int messagesPerChannel = 8;
+
+    std::cout << "Mensagem de garfo (codificação + decodificação), " << iterations << " iterações\n";
+    double textFork = measure("texto  ", iterations, [](long i) {
+        legacy::Message msg{ 0, static_cast<int>(i & 1023), std::to_string(i & 1023) };
+        legacy::Message decoded = legacy::Message::deserialize(msg.serialize());
+        sink += decoded.senderId + std::stoi(decoded.content);
+    });
+    double binaryFork = measure("binário", iterations, [](long i) {
+        Message msg{ MessageType::REQUEST_FORK, static_cast<int32_t>(i & 1023), static_cast<int32_t>(i & 1023) };
+        char buffer[MESSAGE_HEADER_SIZE];
+        size_t size = msg.encode(buffer);
+        Message decoded;
+        Message::decode(std::string_view(buffer, size), decoded);
+        sink += decoded.senderId + decoded.forkId;
+    });
+    std::cout << "  ganho: " << textFork / binaryFork << "x\n";
+
+    legacy::Snapshot textSnap;
+    textSnap.localState = "hungry";
+    textSnap.hasLeftFork = true;
+    textSnap.leftForkId = 3;
+    textSnap.rightForkId = 4;
+    Snapshot binarySnap;
+    binarySnap.localState = PhilosopherState::HUNGRY;
+    binarySnap.hasLeftFork = true;
+    binarySnap.leftForkId = 3;
+    binarySnap.rightForkId = 4;
+    for (int c = 0; c < channels; ++c) {
+        for (int m = 0; m < messagesPerChannel; ++m) {
+            textSnap.channelMessages[c].push_back(legacy::Message{ 2, c, std::to_string(m) }.serialize());
+            binarySnap.channelMessages[c].push_back(Message{ MessageType::FORK_GRANTED, c, m });
+        }
+    }
+
+    long snapIterations = iterations / 10 > 0 ? iterations / 10 : 1;
+    std::cout << "Snapshot com " << channels * messagesPerChannel << " mensagens em trânsito (codificação + decodificação), "
+              << snapIterations << " iterações\n";
+    std::cout << "  tamanho: texto=" << textSnap.serialize().size() << " bytes, binário=" << binarySnap.serialize().size() << " bytes\n";
+    double textSnapTime = measure("texto  ", snapIterations, [&](long) {
+        legacy::Snapshot decoded = legacy::Snapshot::deserialize(textSnap.serialize());
+        // O coordenador deserializava novamente cada mensagem em trânsito
+        for (const auto& [from, msgs] : decoded.channelMessages) {
+            for (const std::string& msg : msgs) sink += legacy::Message::deserialize(msg).type;
+        }
+    });
+    double binarySnapTime = measure("binário", snapIterations, [&](long) {
+        Snapshot decoded;
+        Snapshot::decode(binarySnap.serialize(), decoded);
+        for (const auto& [from, msgs] : decoded.channelMessages) {
+            for (const Message& msg : msgs) sink += static_cast<int>(msg.type);
+        }
+    });
+    std::cout << "  ganho: " << textSnapTime / binarySnapTime << "x\n";
+
+    // Decodificação no coordenador: com estruturas com nós e cópias das mensagens, ou em uma arena reiniciada a cada rodada
+    std::string encodedSnap = binarySnap.serialize();
+    std::cout << "Decodificação do snapshot no coordenador, " << snapIterations << " iterações\n";
+    double nodeTime = measure("mapa   ", snapIterations, [&](long) {
+        Snapshot decoded;
+        Snapshot::decode(encodedSnap, decoded);
+        for (const auto& [from, msgs] : decoded.channelMessages) {
+            for (const Message& msg : msgs) sink += static_cast<int>(msg.type);
+        }
+    });
+    Arena arena;
+    double arenaTime = measure("arena  ", snapIterations, [&](long) {
+        SnapshotView decoded;
+        SnapshotView::decode(arena.copy(encodedSnap), decoded, arena);
+        for (const SnapshotView::Channel& channel : decoded) {
+            for (const MessageView& msg : channel) sink += static_cast<int>(msg.type);
+        }
+        arena.reset();
+    });
+    std::cout << "  ganho: " << nodeTime / arenaTime << "x\n";
+
+    // Mensagem SNAPSHOT_DATA de um filósofo sem mensagens em trânsito, completa ou sem conteúdo (estado local inalterado, "delta_snapshots=1")
+    Snapshot idleSnap;
+    idleSnap.localState = PhilosopherState::THINKING;
+    size_t fullSize = Message{ MessageType::SNAPSHOT_DATA, 3, -1, 1, idleSnap.serialize() }.serialize().size();
+    size_t unchangedSize = Message{ MessageType::SNAPSHOT_DATA, 3, -1, 1 }.serialize().size();
+    std::cout << "SNAPSHOT_DATA sem mensagens em trânsito: completo=" << fullSize << " bytes, sem alterações=" << unchangedSize << " bytes\n";
+    return 0;
+}
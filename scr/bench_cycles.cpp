@@ -0,0 +1,115 @@
+// Benchmark da detecção de deadlocks em grafos de espera sintéticos grandes.
+// Compara o detector iterativo (Tarjan sobre CSR) com a busca recursiva anterior sobre std::map/std::set,
+// reproduzida aqui apenas para comparação (ela só é executada em grafos pequenos, pois estoura a pilha nos grandes).
+//
+// Uso: ./bench_cycles [número de filósofos] [repetições]
+
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "cycle_detector.h"
+
+namespace legacy {
+
+bool hasCycle(int startNode, std::map<int, std::vector<int>>& adj, std::set<int>& visited, std::set<int>& recursionStack) {
+    visited.insert(startNode);
+    recursionStack.insert(startNode);
+    if (adj.count(startNode)) {
+        for (int neighbor : adj[startNode]) {
+            if (!visited.count(neighbor)) {
+                if (hasCycle(neighbor, adj, visited, recursionStack)) return true;
+            } else if (recursionStack.count(neighbor)) {
+                return true;
+            }
+        }
+    }
+    recursionStack.erase(startNode);
+    return false;
+}
+
+} // namespace legacy
+
+// Um único anel com todos os filósofos: i espera por i + 1
+static std::vector<std::pair<int, int>> singleRing(int n) {
+    std::vector<std::pair<int, int>> edges;
+    for (int i = 0; i < n; ++i) edges.emplace_back(i, (i + 1) % n);
+    return edges;
+}
+
+// Vários anéis independentes de tamanho "size"
+static std::vector<std::pair<int, int>> manyRings(int n, int size) {
+    std::vector<std::pair<int, int>> edges;
+    for (int start = 0; start + size <= n; start += size) {
+        for (int i = 0; i < size; ++i) edges.emplace_back(start + i, start + (i + 1) % size);
+    }
+    return edges;
+}
+
+// Cadeia sem ciclo, com cada filósofo esperando pelos dois seguintes (pior caso sem deadlock)
+static std::vector<std::pair<int, int>> chain(int n) {
+    std::vector<std::pair<int, int>> edges;
+    for (int i = 0; i + 1 < n; ++i) {
+        edges.emplace_back(i, i + 1);
+        if (i + 2 < n) edges.emplace_back(i, i + 2);
+    }
+    return edges;
+}
+
+static void run(const std::string& name, int n, const std::vector<std::pair<int, int>>& edges, int repetitions, size_t expected) {
+    CsrGraph graph;
+    CycleDetector detector;
+    size_t found = 0;
+
+    auto begin = std::chrono::steady_clock::now();
+    for (int r = 0; r < repetitions; ++r) {
+        graph.build(n, edges);
+        found = detector.run(graph);
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count() / repetitions;
+
+    size_t membersInCycles = 0;
+    for (size_t i = 0; i < detector.cycleCount(); ++i) {
+        auto [first, last] = detector.cycle(i);
+        membersInCycles += last - first;
+    }
+    std::cout << "  " << name << ": " << edges.size() << " arestas, " << found << " ciclos (" << membersInCycles << " filósofos), "
+              << ms << " ms/execução" << (found == expected ? "" : "  [ERRO: esperado " + std::to_string(expected) + "]") << "\n";
+
+    // A busca recursiva usa uma chamada por nó do caminho e estoura a pilha em grafos grandes
+    if (n <= 10000) {
+        auto legacyBegin = std::chrono::steady_clock::now();
+        bool legacyFound = false;
+        for (int r = 0; r < repetitions; ++r) {
+            std::map<int, std::vector<int>> adj;
+            for (const auto& [from, to] : edges) adj[from].push_back(to);
+            std::set<int> visited;
+            std::set<int> recursionStack;
+            legacyFound = false;
+            for (int v = 0; v < n && !legacyFound; ++v) {
+                if (!visited.count(v)) legacyFound = legacy::hasCycle(v, adj, visited, recursionStack);
+            }
+        }
+        double legacyMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - legacyBegin).count() / repetitions;
+        std::cout << "    busca recursiva anterior: " << legacyMs << " ms/execução (apenas o primeiro ciclo, "
+                  << (legacyFound ? "encontrou" : "nenhum") << ")\n";
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<int> sizes;
+    if (argc > 1) sizes.push_back(std::stoi(argv[1]));
+    else sizes = { 1000, 10000, 100000, 1000000 };
+    int repetitions = argc > 2 ? std::stoi(argv[2]) : 5;
+
+    for (int n : sizes) {
+        std::cout << "Grafo de espera com " << n << " filósofos:\n";
+        run("anel único      ", n, singleRing(n), repetitions, 1);
+        run("anéis de 4      ", n, manyRings(n, 4), repetitions, n / 4);
+        run("cadeia sem ciclo", n, chain(n), repetitions, 0);
+    }
+    return 0;
+}
@@ -0,0 +1,315 @@
+// Gerador de carga reprodutível para o coordenador.
+// Simula N filósofos como clientes leves em um único processo: um laço de eventos (Reactor) escuta nas portas de todos
+// os filósofos e uma thread de agendamento dispara o fim das fases de pensar e comer, sorteadas com uma semente fixa.
+// Os filósofos simulados também participam dos snapshots (estado local e marcadores para os vizinhos, sem gravar
+// mensagens em trânsito), para medir o custo das rodadas sob carga.
+//
+// Uso: ./bench [--duration_s=10] [--distribution=exp|fixed|uniform] [--seed=1] [--coordinator=./coordinator|none]
+//              [opções do cluster, ex.: --philosophers=100 --think_ms=5 --eat_ms=5 --snapshot_interval_ms=200]
+//
+// Por padrão o coordenador é iniciado como processo filho com as mesmas opções do cluster e uma porta de métricas,
+// de onde são lidos a espera na fila dos garfos e a duração das rodadas de snapshot.
+// A disputa esperada pelos garfos é eat_ms / (think_ms + eat_ms).
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "config.h"
+#include "message.h"
+#include "reactor.h"
+#include "snapshot.h"
+
+using Clock = std::chrono::steady_clock;
+
+// Opções do benchmark, separadas das opções do cluster
+struct BenchOptions {
+    int durationS = 10;
+    std::string distribution = "exp";
+    uint64_t seed = 1;
+    std::string coordinator = "./coordinator";
+};
+
+// Estado de um filósofo simulado
+struct SimPhilosopher {
+    PhilosopherState state = PhilosopherState::THINKING;
+    bool hasLeft = false;
+    bool hasRight = false;
+    Clock::time_point requestedAt;
+    // Número de marcadores recebidos e snapshot local de cada rodada em andamento
+    std::map<uint32_t, std::pair<size_t, Snapshot>> rounds;
+};
+
+// Evento agendado: fim da fase de pensar (pede os garfos) ou de comer (libera os garfos)
+struct Event {
+    Clock::time_point at;
+    int philosopher;
+    bool endOfMeal;
+    bool operator>(const Event& other) const { return at > other.at; }
+};
+
+class LoadGenerator {
+public:
+    LoadGenerator(const Config& config, const BenchOptions& options)
+        : config(config), options(options), rng(options.seed), reactor("BENCH", config.host), sims(config.numPhilosophers) {
+        for (int i = 0; i < config.numPhilosophers; ++i) neighbours.push_back(config.neighbours(i));
+    }
+
+    // Abre as portas de todos os filósofos simulados e inicia o laço de eventos
+    bool start() {
+        reactor.setPortHandler([this](int localPort, std::string_view data) { onMessage(localPort, data); });
+        for (int i = 0; i < config.numPhilosophers; ++i) {
+            if (!reactor.listenOn(config.philosopherPort(i))) return false;
+            idByPort[config.philosopherPort(i)] = i;
+        }
+        std::thread([this] { reactor.run(); }).detach();
+        return true;
+    }
+
+    // Executa a carga durante o tempo configurado
+    void run() {
+        std::unique_lock<std::mutex> lock(mtx);
+        auto now = Clock::now();
+        for (int i = 0; i < config.numPhilosophers; ++i) events.push({ now + sample(config.thinkMs), i, false });
+
+        auto end = now + std::chrono::seconds(options.durationS);
+        while (true) {
+            if (events.empty()) cv.wait_until(lock, end);
+            else cv.wait_until(lock, std::min(end, events.top().at));
+            now = Clock::now();
+            if (now >= end) break;
+            while (!events.empty() && events.top().at <= now) {
+                Event event = events.top();
+                events.pop();
+                if (event.endOfMeal) endMeal(event.philosopher, now);
+                else becomeHungry(event.philosopher, now);
+            }
+        }
+        elapsedS = options.durationS;
+    }
+
+    // Imprime vazão, latências observadas pelos clientes e snapshots concluídos
+    void report() {
+        std::lock_guard<std::mutex> lock(mtx);
+        std::cout << "Filósofos=" << config.numPhilosophers << ", distribuição=" << options.distribution << ", semente=" << options.seed
+                  << ", disputa esperada=" << static_cast<double>(config.eatMs) / std::max(1, config.thinkMs + config.eatMs) << "\n";
+        std::cout << "Concessões: " << grants << " (" << grants / elapsedS << "/s), refeições: " << meals << " (" << meals / elapsedS << "/s)\n";
+        printPercentiles("Latência de concessão (pedido -> garfo)", grantLatenciesNs);
+        printPercentiles("Latência para obter os dois garfos", acquireLatenciesNs);
+        std::cout << "Snapshots locais enviados: " << snapshotsSent << "\n";
+    }
+
+private:
+    Config config;
+    BenchOptions options;
+    std::mt19937_64 rng;
+    Reactor reactor;
+    std::vector<SimPhilosopher> sims;
+    std::vector<std::vector<int>> neighbours;
+    std::unordered_map<int, int> idByPort;
+
+    // Protege os filósofos simulados, a fila de eventos e as estatísticas (laço de eventos e thread de agendamento)
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events;
+
+    uint64_t grants = 0;
+    uint64_t meals = 0;
+    uint64_t snapshotsSent = 0;
+    double elapsedS = 1;
+    std::vector<uint64_t> grantLatenciesNs;
+    std::vector<uint64_t> acquireLatenciesNs;
+
+    // Sorteia a duração de uma fase com média "meanMs"
+    Clock::duration sample(int meanMs) {
+        double ms = meanMs;
+        if (options.distribution == "exp" && meanMs > 0) ms = std::exponential_distribution<double>(1.0 / meanMs)(rng);
+        else if (options.distribution == "uniform") ms = std::uniform_real_distribution<double>(0, 2.0 * meanMs)(rng);
+        return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(ms));
+    }
+
+    void send(int port, const Message& msg) {
+        if (msg.content.empty()) {
+            char buffer[MESSAGE_HEADER_SIZE];
+            reactor.sendTo(port, std::string_view(buffer, msg.encode(buffer)));
+        } else {
+            reactor.sendTo(port, msg.serialize());
+        }
+    }
+
+    void becomeHungry(int id, Clock::time_point now) {
+        SimPhilosopher& sim = sims[id];
+        sim.state = PhilosopherState::HUNGRY;
+        sim.requestedAt = now;
+        send(config.coordinatorPort, Message{ MessageType::REQUEST_FORK, id, id });
+        send(config.coordinatorPort, Message{ MessageType::REQUEST_FORK, id, (id + 1) % config.numPhilosophers });
+    }
+
+    void endMeal(int id, Clock::time_point now) {
+        SimPhilosopher& sim = sims[id];
+        sim.state = PhilosopherState::THINKING;
+        sim.hasLeft = sim.hasRight = false;
+        send(config.coordinatorPort, Message{ MessageType::RELEASE_FORK, id, id });
+        send(config.coordinatorPort, Message{ MessageType::RELEASE_FORK, id, (id + 1) % config.numPhilosophers });
+        ++meals;
+        events.push({ now + sample(config.thinkMs), id, false });
+    }
+
+    // Executado na thread do laço de eventos. A porta local pela qual a mensagem chegou identifica o filósofo simulado
+    void onMessage(int localPort, std::string_view data) {
+        auto target = idByPort.find(localPort);
+        Message msg;
+        if (target == idByPort.end() || !Message::decode(data, msg)) return;
+        int id = target->second;
+        std::lock_guard<std::mutex> lock(mtx);
+        auto now = Clock::now();
+
+        if (msg.type == MessageType::FORK_GRANTED) {
+            SimPhilosopher& sim = sims[id];
+            if (msg.forkId == id) sim.hasLeft = true;
+            else sim.hasRight = true;
+            ++grants;
+            grantLatenciesNs.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(now - sim.requestedAt).count());
+            if (sim.hasLeft && sim.hasRight && sim.state == PhilosopherState::HUNGRY) {
+                sim.state = PhilosopherState::EATING;
+                acquireLatenciesNs.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(now - sim.requestedAt).count());
+                events.push({ now + sample(config.eatMs), id, true });
+                cv.notify_one();
+            }
+        } else if (msg.type == MessageType::PREEMPT) {
+            // Garfo revogado para desfazer um deadlock: volta a ser pedido
+            SimPhilosopher& sim = sims[id];
+            if (msg.forkId == id) sim.hasLeft = false;
+            else sim.hasRight = false;
+            send(config.coordinatorPort, Message{ MessageType::REQUEST_FORK, id, msg.forkId });
+        } else if (msg.type == MessageType::MARKER) {
+            onMarker(id, msg);
+        }
+    }
+
+    // No primeiro marcador da rodada grava o estado local e repassa o marcador aos vizinhos;
+    // com os marcadores de todos os canais, envia o snapshot completo (sem mensagens em trânsito) ao coordenador
+    void onMarker(int id, const Message& msg) {
+        SimPhilosopher& sim = sims[id];
+        auto [it, first] = sim.rounds.try_emplace(msg.epoch);
+        auto& [markers, snapshot] = it->second;
+        if (first) {
+            snapshot.localState = sim.state;
+            snapshot.hasLeftFork = sim.hasLeft;
+            snapshot.hasRightFork = sim.hasRight;
+            snapshot.leftForkId = id;
+            snapshot.rightForkId = (id + 1) % config.numPhilosophers;
+            Message marker{ MessageType::MARKER, id };
+            marker.epoch = msg.epoch;
+            for (int neighbour : neighbours[id]) send(config.philosopherPort(neighbour), marker);
+        }
+        if (++markers == neighbours[id].size() + 1) {
+            send(config.coordinatorPort, Message{ MessageType::SNAPSHOT_DATA, id, -1, msg.epoch, snapshot.serialize() });
+            sim.rounds.erase(it);
+            ++snapshotsSent;
+        }
+    }
+
+    static void printPercentiles(const char* name, std::vector<uint64_t>& values) {
+        std::cout << name << ": ";
+        if (values.empty()) {
+            std::cout << "sem amostras\n";
+            return;
+        }
+        std::sort(values.begin(), values.end());
+        auto at = [&](double q) { return values[std::min(values.size() - 1, static_cast<size_t>(q * values.size()))] / 1e3; };
+        std::cout << "p50=" << at(0.5) << "us p99=" << at(0.99) << "us p999=" << at(0.999) << "us max=" << values.back() / 1e3 << "us\n";
+    }
+};
+
+// Lê o relatório da porta de métricas do coordenador
+static std::string fetchMetrics(const std::string& host, int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, host.c_str(), &addr.sin_addr);
+    std::string report;
+    if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) {
+        char buffer[4096];
+        ssize_t n;
+        while ((n = read(fd, buffer, sizeof(buffer))) > 0) report.append(buffer, n);
+    }
+    if (fd >= 0) close(fd);
+    return report;
+}
+
+int main(int argc, char* argv[]) {
+    // Separa as opções do benchmark das opções do cluster, repassadas ao Config e ao coordenador
+    BenchOptions options;
+    std::vector<char*> clusterArgs{ argv[0] };
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--duration_s=", 0) == 0) options.durationS = std::atoi(arg.c_str() + 13);
+        else if (arg.rfind("--distribution=", 0) == 0) options.distribution = arg.substr(15);
+        else if (arg.rfind("--seed=", 0) == 0) options.seed = std::strtoull(arg.c_str() + 7, nullptr, 10);
+        else if (arg.rfind("--coordinator=", 0) == 0) options.coordinator = arg.substr(14);
+        else clusterArgs.push_back(argv[i]);
+    }
+    Config config;
+    std::vector<std::string> positional;
+    if (options.durationS <= 0 || !Config::load(static_cast<int>(clusterArgs.size()), clusterArgs.data(), config, positional)) {
+        std::cerr << "Uso: " << argv[0] << " [--duration_s=N] [--distribution=exp|fixed|uniform] [--seed=N] [--coordinator=caminho|none] [--chave=valor ...]\n";
+        return 1;
+    }
+    setLogLevel(LogLevel::WARN);
+    raiseFileDescriptorLimit(2 * config.numPhilosophers + 64);
+
+    // O coordenador filho usa a mesma configuração, com uma porta de métricas e apenas avisos no log
+    pid_t child = -1;
+    int metricsPort = config.metricsPort > 0 ? config.metricsPort : config.coordinatorPort + 1000;
+    if (options.coordinator != "none") {
+        std::vector<std::string> childArgs{ options.coordinator };
+        for (size_t i = 1; i < clusterArgs.size(); ++i) childArgs.push_back(clusterArgs[i]);
+        childArgs.push_back("--metrics_port=" + std::to_string(metricsPort));
+        childArgs.push_back("--log_level=warn");
+        child = fork();
+        if (child == 0) {
+            std::vector<char*> childArgv;
+            for (std::string& arg : childArgs) childArgv.push_back(arg.data());
+            childArgv.push_back(nullptr);
+            execv(childArgv[0], childArgv.data());
+            perror("execv failed");
+            _exit(127);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    }
+
+    LoadGenerator generator(config, options);
+    if (!generator.start()) {
+        if (child > 0) kill(child, SIGTERM);
+        return 1;
+    }
+    generator.run();
+    generator.report();
+
+    if (options.coordinator != "none" || config.metricsPort > 0) {
+        std::string metrics = fetchMetrics(config.host, metricsPort);
+        std::cout << "Métricas do coordenador:\n" << metrics << std::flush;
+    }
+    if (child > 0) {
+        kill(child, SIGTERM);
+        waitpid(child, nullptr, 0);
+    }
+    std::exit(0);
+}
@@ -0,0 +1,274 @@
+#include "config.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sys/resource.h>
+
+#include "message.h"
+
+// Converte o valor para inteiro, exigindo que a string inteira seja um número
+static bool parseInt(const std::string& value, int& out) {
+    try {
+        size_t pos;
+        out = std::stoi(value, &pos);
+        return pos == value.size();
+    } catch (...) {
+        return false;
+    }
+}
+
+// Remove espaços no início e no fim da string
+static std::string trim(const std::string& s) {
+    size_t begin = s.find_first_not_of(" \t\r");
+    if (begin == std::string::npos) return "";
+    size_t end = s.find_last_not_of(" \t\r");
+    return s.substr(begin, end - begin + 1);
+}
+
+bool Config::set(const std::string& key, const std::string& value) {
+    if (key == "host") {
+        host = value;
+        return true;
+    }
+    if (key == "log_level") {
+        if (!parseLogLevel(value, logLevel)) {
+            std::cerr << "Valor inválido para " << key << ": " << value << " (esperado trace, debug, info, warn, error ou off)\n";
+            return false;
+        }
+        return true;
+    }
+    if (key == "topology") {
+        if (value == "ring") topology = Topology::RING;
+        else if (value == "complete") topology = Topology::COMPLETE;
+        else {
+            std::cerr << "Valor inválido para " << key << ": " << value << " (esperado \"ring\" ou \"complete\")\n";
+            return false;
+        }
+        return true;
+    }
+    if (key == "transport") {
+        if (value == "tcp") transport = TransportKind::TCP;
+        else if (value == "shm") transport = TransportKind::SHM;
+        else {
+            std::cerr << "Valor inválido para " << key << ": " << value << " (esperado \"tcp\" ou \"shm\")\n";
+            return false;
+        }
+        return true;
+    }
+
+    if (key == "acquire_mode") {
+        if (value == "single") acquireMode = AcquireMode::SINGLE;
+        else if (value == "pair") acquireMode = AcquireMode::PAIR;
+        else {
+            std::cerr << "Valor inválido para " << key << ": " << value << " (esperado \"single\" ou \"pair\")\n";
+            return false;
+        }
+        return true;
+    }
+
+    if (key == "deadlock_resolution") {
+        if (value == "off") deadlockResolution = DeadlockResolution::OFF;
+        else if (value == "youngest") deadlockResolution = DeadlockResolution::YOUNGEST;
+        else if (value == "fewest_meals") deadlockResolution = DeadlockResolution::FEWEST_MEALS;
+        else {
+            std::cerr << "Valor inválido para " << key << ": " << value << " (esperado \"off\", \"youngest\" ou \"fewest_meals\")\n";
+            return false;
+        }
+        return true;
+    }
+
+    int* field = nullptr;
+    if (key == "philosophers") field = &numPhilosophers;
+    else if (key == "base_port") field = &basePort;
+    else if (key == "coordinator_port") field = &coordinatorPort;
+    else if (key == "coordinator_shards") field = &coordinatorShards;
+    else if (key == "snapshot_interval_ms") field = &snapshotIntervalMs;
+    else if (key == "think_ms") field = &thinkMs;
+    else if (key == "eat_ms") field = &eatMs;
+    else if (key == "io_threads") field = &ioThreads;
+    else if (key == "max_inflight_snapshots") field = &maxInflightSnapshots;
+    else if (key == "aggregation_fanout") field = &aggregationFanout;
+    else if (key == "delta_snapshots") field = &deltaSnapshots;
+    else if (key == "metrics_port") field = &metricsPort;
+    else if (key == "shm_ring_kb") field = &shmRingKb;
+    else if (key == "send_threads") field = &sendThreads;
+    else if (key == "philosophers_per_process") field = &philosophersPerProcess;
+
+    if (!field) {
+        std::cerr << "Configuração desconhecida: " << key << "\n";
+        return false;
+    }
+    if (!parseInt(value, *field)) {
+        std::cerr << "Valor inválido para " << key << ": " << value << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool Config::loadFile(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Não foi possível abrir o arquivo de configuração " << path << "\n";
+        return false;
+    }
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        line = trim(line);
+        if (line.empty() || line[0] == '#') continue;
+
+        size_t eqPos = line.find('=');
+        if (eqPos == std::string::npos) {
+            std::cerr << path << ":" << lineNumber << ": esperado \"chave=valor\"\n";
+            return false;
+        }
+        if (!set(trim(line.substr(0, eqPos)), trim(line.substr(eqPos + 1)))) return false;
+    }
+    return true;
+}
+
+// As portas de todos os filósofos e a do coordenador precisam ser válidas e distintas
+bool Config::validate() const {
+    if (numPhilosophers < 2) {
+        std::cerr << "São necessários pelo menos 2 filósofos\n";
+        return false;
+    }
+    if (basePort <= 0 || basePort + numPhilosophers - 1 > 65535) {
+        std::cerr << "As portas dos filósofos (" << basePort << " a " << basePort + numPhilosophers - 1 << ") são inválidas\n";
+        return false;
+    }
+    if (coordinatorShards < 1 || coordinatorShards > numPhilosophers) {
+        std::cerr << "O número de fragmentos do coordenador deve estar entre 1 e o número de filósofos\n";
+        return false;
+    }
+    if (acquireMode == AcquireMode::PAIR && coordinatorShards > 1) {
+        std::cerr << "acquire_mode=pair exige coordinator_shards=1\n";
+        return false;
+    }
+    int lastCoordinatorPort = coordinatorPort + coordinatorShards - 1;
+    if (coordinatorPort <= 0 || lastCoordinatorPort > 65535 ||
+        (lastCoordinatorPort >= basePort && coordinatorPort < basePort + numPhilosophers)) {
+        std::cerr << "As portas do coordenador (" << coordinatorPort << " a " << lastCoordinatorPort << ") são inválidas ou conflitam com as portas dos filósofos\n";
+        return false;
+    }
+    if (snapshotIntervalMs <= 0 || thinkMs < 0 || eatMs < 0) {
+        std::cerr << "Os intervalos de tempo não podem ser negativos\n";
+        return false;
+    }
+    if (maxInflightSnapshots < 1) {
+        std::cerr << "É necessário permitir pelo menos 1 snapshot em andamento\n";
+        return false;
+    }
+    if (deltaSnapshots != 0 && deltaSnapshots != 1) {
+        std::cerr << "delta_snapshots deve ser 0 ou 1\n";
+        return false;
+    }
+    if (aggregationFanout < 0) {
+        std::cerr << "O número de filhos da árvore de agregação não pode ser negativo\n";
+        return false;
+    }
+    if (metricsPort < 0 || (metricsPort > 0 && metricsPort + numPhilosophers + coordinatorShards - 1 > 65535)) {
+        std::cerr << "A porta de métricas (" << metricsPort << ") é inválida\n";
+        return false;
+    }
+    if (ioThreads < 1) {
+        std::cerr << "É necessária pelo menos 1 thread de E/S\n";
+        return false;
+    }
+    if (sendThreads < 0) {
+        std::cerr << "O número de threads de envio não pode ser negativo\n";
+        return false;
+    }
+    if (philosophersPerProcess < 1) {
+        std::cerr << "Cada processo precisa hospedar pelo menos 1 filósofo\n";
+        return false;
+    }
+    if (shmRingKb < 4 || shmRingKb > 65536 || (shmRingKb & (shmRingKb - 1)) != 0) {
+        std::cerr << "shm_ring_kb deve ser uma potência de 2 entre 4 e 65536\n";
+        return false;
+    }
+    return true;
+}
+
+// O arquivo de configuração é aplicado antes das demais opções, independentemente da posição de "--config",
+// para que as opções da linha de comando sempre tenham precedência.
+bool Config::load(int argc, char* argv[], Config& config, std::vector<std::string>& positional) {
+    std::vector<std::pair<std::string, std::string>> options;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--", 0) != 0) {
+            positional.push_back(arg);
+            continue;
+        }
+        size_t eqPos = arg.find('=');
+        if (eqPos == std::string::npos) {
+            std::cerr << "Opção inválida: " << arg << " (esperado --chave=valor)\n";
+            return false;
+        }
+        std::string key = arg.substr(2, eqPos - 2);
+        std::string value = arg.substr(eqPos + 1);
+        if (key == "config") {
+            if (!config.loadFile(value)) return false;
+        } else {
+            options.emplace_back(key, value);
+        }
+    }
+
+    for (const auto& [key, value] : options) {
+        if (!config.set(key, value)) return false;
+    }
+    return config.validate();
+}
+
+// Os IDs dos fragmentos do coordenador ficam no topo da faixa de inteiros, acima dos IDs dos filósofos
+int Config::participantPort(int participantId) const {
+    if (isCoordinatorId(participantId)) return coordinatorShardPort(coordinatorShard(participantId));
+    return philosopherPort(participantId);
+}
+
+std::vector<int> Config::neighbours(int philosopherId) const {
+    std::vector<int> result;
+    if (topology == Topology::COMPLETE) {
+        for (int i = 0; i < numPhilosophers; ++i) {
+            if (i != philosopherId) result.push_back(i);
+        }
+        return result;
+    }
+    int left = (philosopherId + numPhilosophers - 1) % numPhilosophers;
+    int right = (philosopherId + 1) % numPhilosophers;
+    result.push_back(left);
+    // Com 2 filósofos os dois vizinhos são o mesmo
+    if (right != left) result.push_back(right);
+    return result;
+}
+
+std::vector<int> Config::aggregationChildren(int philosopherId) const {
+    std::vector<int> result;
+    for (int j = 0; j < aggregationFanout; ++j) {
+        int child = aggregationFanout * (philosopherId + 1) + j;
+        if (child >= numPhilosophers) break;
+        result.push_back(child);
+    }
+    return result;
+}
+
+// Sobe a árvore a partir do filósofo; os ancestrais sempre têm IDs menores, então basta parar ao passar de "root"
+bool Config::inAggregationSubtree(int root, int philosopherId) const {
+    while (philosopherId > root) philosopherId = aggregationParent(philosopherId);
+    return philosopherId == root;
+}
+
+void raiseFileDescriptorLimit(size_t wanted) {
+    rlimit limit{};
+    if (getrlimit(RLIMIT_NOFILE, &limit) < 0) return;
+    if (limit.rlim_cur >= wanted) return;
+
+    limit.rlim_cur = (limit.rlim_max == RLIM_INFINITY || limit.rlim_max > wanted) ? wanted : limit.rlim_max;
+    if (setrlimit(RLIMIT_NOFILE, &limit) < 0) {
+        perror("setrlimit failed");
+    }
+}
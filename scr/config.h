@@ -1,18 +1,143 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
-// Constantes de configuração global do sistema
-
-// Número total de filósofos no sistema.
-const int NUM_PHILOSOPHERS = 3;
-// Porta base para os filósofos.
-//Cada filósofo 'i' usará a porta BASE_PORT + i.
-const int BASE_PORT = 5000;
-// Porta do Coordenador.
-const int COORDINATOR_PORT = 6000;
-// Endereço IP padrão para comunicação local
-const char* LOCALHOST = "127.0.0.1";
-// Intervalo (em segundos) entre as iniciações de snapshots pelo Coordenador.
-const int SNAPSHOT_INTERVAL = 5;
-
-#endif
\ No newline at end of file
+#include <string>
+#include <vector>
+
+#include "log.h"
+
+// Grafo de canais entre os filósofos sobre o qual os marcadores do snapshot são propagados.
+// Todo filósofo também tem um canal com o coordenador, independentemente da topologia.
+enum class Topology {
+    // Cada filósofo se comunica apenas com seus vizinhos no anel (i - 1 e i + 1): O(N) marcadores por rodada
+    RING,
+    // Todos os filósofos se comunicam entre si: O(N²) marcadores por rodada
+    COMPLETE
+};
+
+// Meio de troca de mensagens entre os processos
+enum class TransportKind {
+    // Conexões TCP persistentes (os processos podem estar em hosts diferentes)
+    TCP,
+    // Buffers circulares em memória compartilhada POSIX, um por canal (todos os processos no mesmo host)
+    SHM
+};
+
+// Forma como os filósofos pedem os garfos ao coordenador
+enum class AcquireMode {
+    // Um pedido por garfo: o filósofo pode segurar um garfo enquanto espera pelo outro (permite reproduzir deadlocks)
+    SINGLE,
+    // Um único pedido pelos dois garfos, concedidos juntos ou nenhum: uma ida e volta por refeição e sem deadlocks
+    PAIR
+};
+
+// Critério de escolha da vítima cujo garfo é revogado para desfazer um deadlock detectado
+enum class DeadlockResolution {
+    // Os deadlocks são apenas detectados e impressos
+    OFF,
+    // O filósofo do ciclo com o pedido mais recente
+    YOUNGEST,
+    // O filósofo do ciclo que menos comeu
+    FEWEST_MEALS
+};
+
+// Configuração global do sistema, carregada na inicialização de cada processo.
+// Os valores padrão podem ser sobrescritos por um arquivo de configuração ("--config=arquivo")
+// e depois por opções da linha de comando no formato "--chave=valor", com as mesmas chaves do arquivo.
+struct Config {
+    // Número total de filósofos no sistema (chave "philosophers").
+    int numPhilosophers = 3;
+    // Porta base para os filósofos (chave "base_port").
+    // Cada filósofo 'i' usará a porta basePort + i.
+    int basePort = 5000;
+    // Porta do Coordenador (chave "coordinator_port").
+    // Com vários fragmentos, o fragmento 's' usa a porta coordinatorPort + s
+    int coordinatorPort = 6000;
+    // Número de fragmentos do coordenador (chave "coordinator_shards"). O garfo 'f' é arbitrado pelo fragmento f % coordinator_shards;
+    // o fragmento 0 também inicia as rodadas de snapshot e detecta os deadlocks
+    int coordinatorShards = 1;
+    // Endereço IP usado para se conectar aos outros processos (chave "host").
+    std::string host = "127.0.0.1";
+    // Intervalo (em milissegundos) entre as iniciações de snapshots pelo Coordenador (chave "snapshot_interval_ms").
+    int snapshotIntervalMs = 5000;
+    // Tempo (em milissegundos) que cada filósofo passa pensando (chave "think_ms").
+    int thinkMs = 2000;
+    // Tempo (em milissegundos) que cada filósofo passa comendo (chave "eat_ms").
+    int eatMs = 2000;
+    // Número máximo de rodadas de snapshot em andamento ao mesmo tempo; as mais antigas são descartadas (chave "max_inflight_snapshots").
+    int maxInflightSnapshots = 4;
+    // Topologia dos canais entre filósofos, "ring" ou "complete" (chave "topology").
+    Topology topology = Topology::RING;
+    // Com 1, os filósofos enviam o snapshot sem conteúdo quando o estado local não mudou desde o último enviado e não há mensagens
+    // em trânsito (chave "delta_snapshots"). Não é um delta por campo nem por canal: as mensagens em trânsito são de cada rodada
+    // e nunca se repetem, então só o snapshot inteiro inalterado é omitido, e sem confirmação do coordenador
+    // (a ordem das mensagens de cada filósofo basta para que ele use a mesma referência)
+    int deltaSnapshots = 0;
+    // Número de filhos de cada nó da árvore de agregação dos snapshots (chave "aggregation_fanout").
+    // Com 0 (padrão) cada filósofo envia seu snapshot completo diretamente ao coordenador.
+    int aggregationFanout = 0;
+    // Nível mínimo das mensagens de log: trace, debug, info, warn, error ou off (chave "log_level").
+    LogLevel logLevel = LogLevel::INFO;
+    // Porta de métricas do coordenador; o filósofo 'i' usa metrics_port + 1 + i. Com 0 (padrão), as métricas só
+    // podem ser obtidas enviando SIGUSR1 ao processo (chave "metrics_port").
+    int metricsPort = 0;
+    // Número de threads de E/S do coordenador, cada uma com seu próprio laço de eventos (chave "io_threads").
+    int ioThreads = 1;
+    // Meio de troca de mensagens, "tcp" ou "shm" (chave "transport").
+    TransportKind transport = TransportKind::TCP;
+    // Tamanho (em KB, potência de 2) do buffer circular de cada canal no transporte "shm" (chave "shm_ring_kb").
+    int shmRingKb = 64;
+    // Número de threads que fazem os envios de cada filósofo, de forma assíncrona (chave "send_threads").
+    // Com 0 as mensagens são enviadas na própria thread que as produz
+    int sendThreads = 2;
+    // Número de filósofos hospedados por cada processo "philosopher" (chave "philosophers_per_process").
+    // Com mais de 1, o processo do grupo 'g' hospeda os filósofos g * N a g * N + N - 1, todos na porta do primeiro deles
+    int philosophersPerProcess = 1;
+
+    // Forma de pedir os garfos, "single" ou "pair" (chave "acquire_mode"). Com "pair" o coordenador não pode ser fragmentado,
+    // pois os dois garfos de um filósofo são arbitrados por fragmentos diferentes
+    AcquireMode acquireMode = AcquireMode::SINGLE;
+    // Resolução dos deadlocks detectados nos snapshots, "off" (padrão), "youngest" ou "fewest_meals" (chave "deadlock_resolution").
+    // Um filósofo do ciclo é escolhido como vítima e perde o garfo que possui para quem espera por ele.
+    // Só tem efeito com coordinator_shards=1, pois a vítima e o garfo podem pertencer a fragmentos diferentes
+    DeadlockResolution deadlockResolution = DeadlockResolution::OFF;
+
+    // Porta em que o filósofo especificado escuta: a do primeiro filósofo do processo que o hospeda
+    int philosopherPort(int philosopherId) const { return basePort + philosopherId - philosopherId % philosophersPerProcess; }
+    // Fragmento do coordenador que arbitra o garfo especificado, e a porta em que um fragmento escuta
+    int forkShard(int forkId) const { return forkId % coordinatorShards; }
+    int coordinatorShardPort(int shard) const { return coordinatorPort + shard; }
+    // Porta em que escuta o participante com o ID especificado (um filósofo ou um fragmento do coordenador)
+    int participantPort(int participantId) const;
+    // IDs dos filósofos com quem o filósofo especificado tem canais, de acordo com a topologia (sem repetições)
+    std::vector<int> neighbours(int philosopherId) const;
+    // Árvore de agregação: o coordenador é a raiz e tem os filósofos 0 a aggregation_fanout - 1 como filhos;
+    // o filósofo 'i' tem como filhos os filósofos aggregation_fanout * (i + 1) + j.
+    // Pai do filósofo especificado na árvore, ou -1 quando o pai é o coordenador
+    int aggregationParent(int philosopherId) const {
+        return philosopherId < aggregationFanout ? -1 : philosopherId / aggregationFanout - 1;
+    }
+    // Filhos do filósofo especificado (ou do coordenador, com -1) na árvore de agregação
+    std::vector<int> aggregationChildren(int philosopherId) const;
+    // Verifica se o filósofo "philosopherId" está na subárvore de "root" (-1 para a árvore inteira)
+    bool inAggregationSubtree(int root, int philosopherId) const;
+
+    // Carrega a configuração a partir dos argumentos do programa.
+    // Os argumentos que não começam com "--" são devolvidos em "positional", na ordem em que aparecem.
+    // Retorna falso (após imprimir o motivo em std::cerr) se algum valor for inválido.
+    static bool load(int argc, char* argv[], Config& config, std::vector<std::string>& positional);
+
+private:
+    // Atribui o valor a uma chave. Retorna falso se a chave não existir ou o valor for inválido
+    bool set(const std::string& key, const std::string& value);
+    // Lê um arquivo com uma linha "chave=valor" por configuração. Linhas vazias ou iniciadas por '#' são ignoradas
+    bool loadFile(const std::string& path);
+    // Verifica se a configuração é consistente
+    bool validate() const;
+};
+
+// Aumenta o limite de descritores de arquivos abertos do processo para pelo menos "wanted" (ou o máximo permitido).
+// Necessário para manter uma conexão persistente por filósofo em clusters grandes.
+void raiseFileDescriptorLimit(size_t wanted);
+
+#endif
@@ -0,0 +1,208 @@
+#include "connection.h"
+
+#include <chrono>
+#include <thread>
+#include <iostream>
+#include <cerrno>
+#include <cstdio>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "frame.h"
+#include "log.h"
+
+ConnectionPool::ConnectionPool(const std::string& owner, const std::string& host) : owner(owner), host(host) {}
+
+ConnectionPool::~ConnectionPool() {
+    for (auto& [port, peer] : peers) {
+        if (peer->fd >= 0) close(peer->fd);
+    }
+}
+
+// Adquire o lock do mapa apenas para localizar o destino. Os envios em si usam o lock de cada destino.
+ConnectionPool::Peer& ConnectionPool::peerFor(int port) {
+    std::lock_guard<std::mutex> lock(peersMtx);
+    std::unique_ptr<Peer>& peer = peers[port];
+    if (!peer) peer = std::make_unique<Peer>();
+    return *peer;
+}
+
+// Cria um socket e se conecta à porta especificada no endereço configurado.
+// Desativa o algoritmo de Nagle, já que as mensagens são pequenas e sensíveis à latência.
+int ConnectionPool::connectTo(int port) {
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock < 0) {
+        perror("socket creation failed");
+        return -1;
+    }
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, host.c_str(), &addr.sin_addr) <= 0) {
+        perror("Invalid address/ Address not supported");
+        close(sock);
+        return -1;
+    }
+    if (connect(sock, (sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(sock);
+        return -1;
+    }
+    int enable = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+    return sock;
+}
+
+// Envia o cabeçalho e o conteúdo com uma única chamada "sendmsg", sem concatená-los em um novo buffer,
+// repetindo até que todos os bytes tenham sido escritos.
+// Usa MSG_NOSIGNAL para que uma conexão fechada pelo outro lado não encerre o processo com SIGPIPE.
+bool ConnectionPool::writeFrame(int fd, std::string_view data) {
+    char header[FRAME_HEADER_SIZE];
+    encodeFrameHeader(static_cast<uint32_t>(data.size()), header);
+
+    iovec parts[2];
+    parts[0].iov_base = header;
+    parts[0].iov_len = FRAME_HEADER_SIZE;
+    parts[1].iov_base = const_cast<char*>(data.data());
+    parts[1].iov_len = data.size();
+    iovec* iov = parts;
+    int iovcnt = 2;
+
+    while (iovcnt > 0) {
+        msghdr msg{};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = iovcnt;
+        ssize_t sent = sendmsg(fd, &msg, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        while (iovcnt > 0 && static_cast<size_t>(sent) >= iov->iov_len) {
+            sent -= iov->iov_len;
+            ++iov;
+            --iovcnt;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = static_cast<char*>(iov->iov_base) + sent;
+            iov->iov_len -= sent;
+        }
+    }
+    return true;
+}
+
+// Reaproveita a conexão existente com o destino. Se ela não existir ou falhar durante o envio,
+// a conexão é refeita e o envio é tentado mais uma vez.
+bool ConnectionPool::send(int port, std::string_view data) {
+    Peer& peer = peerFor(port);
+    std::lock_guard<std::mutex> lock(peer.mtx);
+
+    auto begin = std::chrono::steady_clock::now();
+
+    bool delivered = false;
+    for (int attempt = 0; attempt < 2 && !delivered; ++attempt) {
+        if (peer.fd < 0) {
+            peer.fd = connectTo(port);
+            if (peer.fd < 0) break;
+            if (peer.sends > 0 || attempt > 0) peer.reconnects++;
+        }
+        delivered = writeFrame(peer.fd, data);
+        if (!delivered) {
+            close(peer.fd);
+            peer.fd = -1;
+        }
+    }
+
+    if (!delivered) {
+        peer.failures++;
+        return false;
+    }
+
+    uint64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count();
+    peer.sends++;
+    peer.totalNs += elapsed;
+    if (elapsed > peer.maxNs) peer.maxNs = elapsed;
+    return true;
+}
+
+// Abre um socket, vincula-o à porta especificada e fica aguardando conexões.
+// Cada conexão é persistente e atendida por uma thread própria, que lê as mensagens enquanto ela estiver aberta.
+bool ConnectionPool::listen(int port, const MessageHandler& handler) {
+    int sockfd = socket(AF_INET, SOCK_STREAM, 0);
+    if (sockfd < 0) {
+        perror("socket creation failed");
+        return false;
+    }
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = INADDR_ANY;
+
+    int enable = 1;
+    if (setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(int)) < 0) {
+        perror("setsockopt(SO_REUSEADDR) failed");
+    }
+    if (bind(sockfd, (sockaddr*)&addr, sizeof(addr)) < 0 || ::listen(sockfd, 20) < 0) {
+        perror("bind failed");
+        close(sockfd);
+        return false;
+    }
+
+    while (true) {
+        sockaddr_in cli{};
+        socklen_t clilen = sizeof(cli);
+        int client = accept(sockfd, (sockaddr*)&cli, &clilen);
+        if (client < 0) {
+            perror("accept failed");
+            continue;
+        }
+        std::thread(serveConnection, client, handler).detach();
+    }
+    close(sockfd);
+    return true;
+}
+
+// Imprime, para cada destino, a quantidade de envios, as latências média e máxima (em microssegundos),
+// as reconexões e as falhas.
+void ConnectionPool::printStats(std::ostream& out) {
+    std::lock_guard<std::mutex> lock(peersMtx);
+    for (auto& [port, peer] : peers) {
+        std::lock_guard<std::mutex> peerLock(peer->mtx);
+        double avgUs = peer->sends ? (peer->totalNs / 1000.0) / peer->sends : 0.0;
+        out << "[" << owner << "] Conexão porta " << port
+            << ": envios=" << peer->sends
+            << ", latência média=" << avgUs << "us"
+            << ", máxima=" << peer->maxNs / 1000.0 << "us"
+            << ", reconexões=" << peer->reconnects
+            << ", falhas=" << peer->failures << "\n";
+    }
+    out << std::flush;
+}
+
+// Usa um único "FrameReader" por conexão: cada leitura pode conter várias mensagens ou apenas parte de uma,
+// e as mensagens completas são entregues diretamente do buffer de recepção.
+void serveConnection(int fd, const std::function<void(std::string_view)>& onMessage) {
+    FrameReader reader;
+
+    while (true) {
+        ssize_t valread = reader.fill(fd);
+        if (valread < 0) {
+            if (errno == EINTR) continue;
+            perror("read failed");
+            break;
+        }
+        if (valread == 0) break;
+
+        std::string_view payload;
+        while (reader.next(payload)) {
+            onMessage(payload);
+        }
+        if (reader.corrupted()) {
+            LOG_WARN("Mensagem com cabeçalho inválido recebida. Encerrando conexão.");
+            break;
+        }
+    }
+    close(fd);
+}
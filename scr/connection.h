@@ -0,0 +1,69 @@
+#ifndef CONNECTION_H
+#define CONNECTION_H
+
+#include <string>
+#include <string_view>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <functional>
+#include <ostream>
+#include <cstdint>
+
+#include "transport.h"
+
+
+// Mantém uma conexão TCP persistente por par de processos (identificado pela porta de destino).
+// Em vez de abrir um socket, conectar, enviar e fechar para cada mensagem, a conexão é reaproveitada
+// enquanto estiver válida e é restabelecida automaticamente em caso de falha.
+// Também registra a latência de envio por destino, para que o ganho possa ser observado.
+class ConnectionPool : public Transport {
+public:
+    // Construtor da classe. "owner" é usado apenas para identificar o dono nas mensagens impressas
+    // e "host" é o endereço usado para as conexões
+    ConnectionPool(const std::string& owner, const std::string& host);
+    // Fecha todas as conexões abertas
+    ~ConnectionPool();
+
+    // Envia uma mensagem (já serializada) para o processo que escuta na porta especificada.
+    // Retorna falso se não foi possível entregar a mensagem mesmo após uma reconexão.
+    bool send(int port, std::string_view data) override;
+    // Escuta na porta especificada e atende cada conexão aceita em uma thread própria. Não retorna se conseguir escutar
+    bool listen(int port, const MessageHandler& handler) override;
+    // Imprime as estatísticas de envio de cada destino
+    void printStats(std::ostream& out);
+
+private:
+    // Estado de uma conexão com um destino específico
+    struct Peer {
+        // Serializa os envios para o mesmo destino, mantendo as mensagens inteiras no fluxo
+        std::mutex mtx;
+        int fd = -1;
+        // Estatísticas de envio
+        uint64_t sends = 0;
+        uint64_t failures = 0;
+        uint64_t reconnects = 0;
+        uint64_t totalNs = 0;
+        uint64_t maxNs = 0;
+    };
+
+    std::string owner;
+    std::string host;
+    // Protege apenas o mapa de destinos, e não os envios em si
+    std::mutex peersMtx;
+    std::map<int, std::unique_ptr<Peer>> peers;
+
+    // Retorna (criando se necessário) o estado da conexão com a porta especificada
+    Peer& peerFor(int port);
+    // Abre uma nova conexão com a porta especificada. Retorna -1 em caso de falha
+    int connectTo(int port);
+    // Escreve o cabeçalho e o conteúdo da mensagem no socket. Retorna falso se a conexão falhou
+    static bool writeFrame(int fd, std::string_view data);
+};
+
+// Lê mensagens enquadradas de uma conexão persistente até que ela seja fechada pelo outro lado,
+// chamando "onMessage" para cada mensagem completa recebida. A "string_view" entregue aponta para o
+// buffer de recepção da conexão e só é válida durante a chamada. Fecha o socket ao terminar.
+void serveConnection(int fd, const std::function<void(std::string_view)>& onMessage);
+
+#endif
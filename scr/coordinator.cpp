@@ -1,342 +1,572 @@
 #include "coordinator.h"
 
-// Inicializa o Mapa dos garfos para indicar que todos estão disponíveis e a flag de deadlock como falsa e define o id do coordenador como 999
-Coordinator::Coordinator(){
+// Número máximo de caracteres de um ID impresso no log (com o sinal)
+static const size_t MAX_ID_DIGITS = 11;
+
+// Inicializa a tabela dos garfos com todos disponíveis, cria um laço de eventos por thread de E/S (exceto com um transporte próprio),
+// define a flag de deadlock como falsa e o id do coordenador como o do fragmento (COORDINATOR_ID para o fragmento 0).
+// A tabela tem todos os garfos, mas o fragmento só aceita pedidos pelos que arbitra
+Coordinator::Coordinator(const Config& config, int shard, Transport* transport)
+    : config(config), waitGraph(config.numPhilosophers, config.numPhilosophers), forks(config.numPhilosophers),
+      meals(new std::atomic<uint64_t>[config.numPhilosophers]), shard(shard), transport(transport) {
     deadlockDetected = false;
-    id = 999;
-    for (int i = 0; i < NUM_PHILOSOPHERS; ++i)
-        forkAvailable[i] = true;
-    std::cout << "[COORDENADOR] Inicializado. NUM_PHILOSOPHERS=" << NUM_PHILOSOPHERS << "\n" << std::flush;
+    for (int i = 0; i < config.numPhilosophers; ++i) meals[i].store(0, std::memory_order_relaxed);
+    id = coordinatorId(shard);
+    lastSnapshots.resize(config.numPhilosophers);
+    hasLastSnapshot.resize(config.numPhilosophers);
+    expectedSnapshots = config.aggregationFanout > 0 ? config.aggregationChildren(-1).size() : config.numPhilosophers;
+    waitGraph.setDeadlockHandler([this](const std::vector<int>& cycle) { onLiveDeadlock(cycle); });
+    forks.attachGraph(&waitGraph);
+    for (int i = 0; !transport && i < config.ioThreads; ++i)
+        reactors.push_back(std::make_unique<Reactor>("COORDENADOR/E/S " + std::to_string(i), config.host));
+    if (config.coordinatorShards > 1)
+        LOG_INFO("[COORDENADOR] Inicializado. Filósofos=" << config.numPhilosophers << ", Fragmento=" << shard << "/" << config.coordinatorShards);
+    else
+        LOG_INFO("[COORDENADOR] Inicializado. Filósofos=" << config.numPhilosophers);
 }
 
-// Cria duas threads, uma para o loop principal do coordenador e outra para o recebimento de mensagens
-// Usa o join para garantir que o programa espere ambas terminarem para seguir
+// Cria uma thread para o loop principal do coordenador (apenas no fragmento 0, que inicia os snapshots) e uma para cada
+// laço de eventos de recebimento de mensagens (ou uma única, para o transporte fornecido no construtor)
+// Usa o join para garantir que o programa espere todas terminarem para seguir
 void Coordinator::start() {
-    std::thread t1(&Coordinator::listenLoop, this);
-    std::thread t2(&Coordinator::runLoop, this);
-    t1.join();
-    t2.join();
+    std::vector<std::thread> threads;
+    if (transport)
+        threads.emplace_back(&Coordinator::listenLoop, this, std::ref(*transport));
+    for (auto& reactor : reactors)
+        threads.emplace_back(&Coordinator::listenLoop, this, std::ref(static_cast<Transport&>(*reactor)));
+    if (shard == 0)
+        threads.emplace_back(&Coordinator::runLoop, this);
+    for (std::thread& t : threads)
+        t.join();
 }
 
-// Loop executado periodicamente, com um tempo definido pela variável SNAPSHOT_INTERVAL.
-// A cada interação, ele verefica se um deadlock foi detectado na interação de snapshot anterior
-// Limpa os dados do snapshot anterior para uma nova interação
+// Loop executado periodicamente, com um tempo definido pela configuração "snapshot_interval_ms".
 void Coordinator::runLoop() {
     using namespace std::chrono_literals;
     while (true) {
-        std::this_thread::sleep_for(std::chrono::seconds(SNAPSHOT_INTERVAL));
-        std::unique_lock<std::mutex> lock(mtx);
-        if (deadlockDetected) {
-            std::cout << "[COORDENADOR] Deadlock detectado no snapshot anterior. Iniciando novo ciclo de detecção para monitoramento contínuo.\n" << std::flush;
-            deadlockDetected = false; 
-        }
-
-        snapshots.clear();
-        std::cout << "[COORDENADOR] Limpando snapshots anteriores antes de iniciar novo ciclo.\n" << std::flush;
-        initiateSnapshot();
+        std::this_thread::sleep_for(std::chrono::milliseconds(config.snapshotIntervalMs));
+        startSnapshotRound();
     }
 }
 
-// Coordenador abre um socket, vinucula ele à porta "COORDINATOR_PORT" e aguarda conexões dos filósofos
-// Ao receber uma conexão, lê os dados e os deserializa e despacha para a função responsável pelo tratamneto correspondente deles
-void Coordinator::listenLoop() {
-    int sockfd = socket(AF_INET, SOCK_STREAM, 0);
-    sockaddr_in addr{};
-    addr.sin_family = AF_INET;
-    addr.sin_port = htons(COORDINATOR_PORT);
-    // Aceita conexões de qualquer endereço
-    addr.sin_addr.s_addr = INADDR_ANY;
+// Verifica se um deadlock foi detectado na rodada de snapshot anterior.
+// Inicia uma nova rodada com uma nova época, sem esperar que as anteriores terminem. Se houver rodadas demais em andamento, as mais antigas são descartadas
+void Coordinator::startSnapshotRound() {
+    std::unique_lock<std::mutex> lock(mtx);
+    if (deadlockDetected) {
+        LOG_INFO("[COORDENADOR] Deadlock detectado no snapshot anterior. Iniciando novo ciclo de detecção para monitoramento contínuo.");
+        deadlockDetected = false; 
+    }
 
-    int enable = 1;
-    if (setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(int)) < 0) {
-        perror("setsockopt failed");
+    while (rounds.size() >= static_cast<size_t>(config.maxInflightSnapshots)) {
+        auto oldest = rounds.begin();
+        LOG_WARN("[COORDENADOR] Descartando rodada de snapshot " << oldest->first << " incompleta ("
+                  << oldest->second.receivedCount << "/" << expectedSnapshots << " snapshots recebidos).");
+        endRound(oldest);
+        count(Counter::SNAPSHOTS_DROPPED);
     }
+    uint32_t epoch = nextEpoch++;
+    beginRound(epoch);
+    printStats();
+    initiateSnapshot(epoch);
+}
 
-    bind(sockfd, (sockaddr*)&addr, sizeof(addr));
-    listen(sockfd, 10);
-    std::cout << "[COORDENADOR] Aguardando conexões na porta " << COORDINATOR_PORT << "...\n" << std::flush;
+// Cada fragmento imprime as suas estatísticas ao iniciar ou repassar uma rodada de snapshot
+void Coordinator::printStats() {
+    if (!logEnabled(LogLevel::INFO)) return;
+    std::ostringstream stats;
+    for (auto& reactor : reactors)
+        reactor->printStats(stats);
+    forks.printStats(stats);
+    logText(LogLevel::INFO, stats.str());
+}
 
-    while (true) {
-        sockaddr_in client_addr{};
-        socklen_t client_sock = sizeof(client_addr);
-        int client = accept(sockfd, (sockaddr*)&client_addr, &client_sock);
-        if (client < 0) {
-            perror("accept failed");
-            continue;
-        }
-        char buffer[1024] = {0};
-        int value_read = read(client, buffer, 1024);
-        if (value_read < 0) {
-            perror("read failed");
-            close(client);
-            continue;
-        }
-        std::string received_data(buffer, value_read);
-
-        // Deserializa a mensagem recebida
-        Message msg = Message::deserialize(received_data);
-        std::cout << "[COORDENADOR] Recebeu mensagem: Tipo=" << static_cast<int>(msg.type)
-                  << ", Remetente=" << msg.senderId << ", Conteúdo=" << msg.content << "\n" << std::flush;
-
-        // Envia a mensagem para a função handler correspondente
-        if (msg.type == MessageType::REQUEST_FORK) {
-            // Função que cuida do pedido de garfo
-            handleRequest(msg.senderId, std::stoi(msg.content));
-        } else if (msg.type == MessageType::RELEASE_FORK) {
-            // Função que cuida da liberação de garfo
-            handleRelease(msg.senderId, std::stoi(msg.content));
-        } else if (msg.type == MessageType::SNAPSHOT_DATA) {
-            // Funlçao que cuida da análise do snapshot
-            handleSnapshot(msg.senderId, msg.content);
-        }
-        close(client);
+// Cada thread de E/S escuta na porta do fragmento pelo seu transporte. No TCP, cada uma abre um socket não bloqueante
+// com SO_REUSEPORT e executa seu laço de eventos (epoll), e o kernel distribui as conexões dos filósofos entre as threads.
+// Cada mensagem recebida é despachada para "dispatch"
+void Coordinator::listenLoop(Transport& receiver) {
+    int port = config.coordinatorShardPort(shard);
+    LOG_INFO("[COORDENADOR] Aguardando conexões na porta " << port << "...");
+    if (!receiver.listen(port, [this](std::string_view data) { dispatch(data); })) {
+        LOG_ERROR("[COORDENADOR] Não foi possível escutar na porta " << port);
     }
-    close(sockfd);
 }
 
-// Adiquire um lock para proteger o Mapa "forkAvalible"
-// Se o garfo solicitado estiver disponível, ele é marcado como indisponível e envia uma mensagem de sucesso ao filósofo solicitante
-// Caso não esteja, é apenas imprimido uma mensagem no terminal
+// Deserializa a mensagem recebida e a envia para a função handler correspondente
+// A mensagem é decodificada sem cópias: o conteúdo de um snapshot só é copiado para a arena da sua rodada
+void Coordinator::dispatch(std::string_view received_data) {
+    MessageView msg;
+    if (!MessageView::decode(received_data, msg)) {
+        LOG_WARN("[COORDENADOR] Mensagem inválida recebida. Ignorando.");
+        return;
+    }
+    count(Counter::MESSAGES_RECEIVED);
+    LOG_TRACE("[COORDENADOR] Recebeu mensagem: Tipo=" << messageTypeName(msg.type)
+              << ", Remetente=" << msg.senderId << ", Garfo=" << msg.forkId << ", Conteúdo=" << msg.content.size() << " bytes");
+
+    if (msg.type == MessageType::REQUEST_FORK) {
+        // Função que cuida do pedido de garfo
+        handleRequest(msg.senderId, msg.forkId);
+    } else if (msg.type == MessageType::RELEASE_FORK) {
+        // Função que cuida da liberação de garfo
+        handleRelease(msg.senderId, msg.forkId);
+    } else if (msg.type == MessageType::ACQUIRE_PAIR) {
+        handleAcquirePair(msg.senderId, msg.forkId);
+    } else if (msg.type == MessageType::RELEASE_PAIR) {
+        handleReleasePair(msg.senderId, msg.forkId);
+    } else if (msg.type == MessageType::SNAPSHOT_DATA || msg.type == MessageType::SNAPSHOT_SUMMARY) {
+        // Funlçao que cuida da análise do snapshot
+        handleSnapshot(msg.senderId, msg.epoch, msg.content);
+    } else if (msg.type == MessageType::MARKER && shard != 0) {
+        // Início de uma rodada de snapshot pelo fragmento 0
+        forwardMarker(msg.epoch);
+    }
+}
+
+// Tenta tomar o garfo com compare-and-swap na tabela de garfos, sem lock global
+// Se o garfo solicitado estiver disponível, ele passa a pertencer ao filósofo e envia uma mensagem de sucesso ao filósofo solicitante
+// Caso não esteja, o filósofo entra na fila do garfo e o receberá quando o dono atual o liberar
 void Coordinator::handleRequest(int fromId, int forkId) {
-    
-    std::lock_guard<std::mutex> lock(mtx);
-    if (forkAvailable[forkId]) {
-        forkAvailable[forkId] = false;
-        Message msg{ MessageType::FORK_GRANTED, forkId, std::to_string(forkId) };
-        sendMessage(BASE_PORT + fromId, msg.serialize());
-        std::cout << "[COORDENADOR] Garfo " << forkId << " concedido ao filósofo " << fromId << "\n" << std::flush;
-    } else {
-        std::cout << "[COORDENADOR] Filósofo " << fromId << " solicitou garfo " << forkId << ", mas não está disponível.\n" << std::flush;
+    if (fromId < 0 || fromId >= config.numPhilosophers || !forks.valid(forkId) || config.forkShard(forkId) != shard ||
+        config.acquireMode != AcquireMode::SINGLE) {
+        LOG_WARN("[COORDENADOR] Pedido inválido do filósofo " << fromId << " pelo garfo " << forkId << ". Ignorando.");
+        return;
+    }
+    count(Counter::FORK_REQUESTS);
+    ForkTable::Grant grant = forks.acquire(forkId, fromId);
+    if (grant.granted()) {
+        grantFork(forkId, grant);
+    }
+    if (grant.philosopherId != fromId) {
+        LOG_DEBUG("[COORDENADOR] Filósofo " << fromId << " solicitou garfo " << forkId << ", mas não está disponível. Aguardando na fila.");
     }
 }
 
-// Adiquire um lock para proteger o Mapa "forkAvalible"
-// Marca o garfo solto como disponível
+// Marca o garfo solto como disponível com compare-and-swap, desde que ele pertença ao filósofo
+// Se houver filósofos na fila do garfo, ele é passado diretamente ao primeiro deles
 void Coordinator::handleRelease(int fromId, int forkId) {
-    std::lock_guard<std::mutex> lock(mtx);
-    forkAvailable[forkId] = true;
-    std::cout << "[COORDENADOR] Garfo " << forkId << " liberado pelo filósofo " << fromId << "\n" << std::flush;
+    ForkTable::Grant next;
+    if (forks.release(forkId, fromId, next)) {
+        count(Counter::FORK_RELEASES);
+        LOG_DEBUG("[COORDENADOR] Garfo " << forkId << " liberado pelo filósofo " << fromId);
+        if (next.granted()) {
+            grantFork(forkId, next);
+        }
+    } else {
+        LOG_WARN("[COORDENADOR] Filósofo " << fromId << " tentou liberar o garfo " << forkId << ", que não é seu. Ignorando.");
+    }
+}
+
+// Envia o FORK_GRANTED ao filósofo que recebeu o garfo, informando quanto tempo ele esperou na fila
+// Se o filósofo já possuía o seu outro garfo, a concessão conta como uma refeição
+void Coordinator::grantFork(int forkId, const ForkTable::Grant& grant) {
+    sendMessage(grant.philosopherId, Message{ MessageType::FORK_GRANTED, id, forkId });
+    count(Counter::FORK_GRANTS);
+    int otherFork = forkId == grant.philosopherId ? (forkId + 1) % config.numPhilosophers : grant.philosopherId;
+    if (forks.owner(otherFork) == grant.philosopherId)
+        meals[grant.philosopherId].fetch_add(1, std::memory_order_relaxed);
+    record(Histogram::FORK_GRANT_WAIT_NS, grant.waitNs);
+    if (grant.waitNs > 0)
+        LOG_DEBUG("[COORDENADOR] Garfo " << forkId << " concedido ao filósofo " << grant.philosopherId << " após " << grant.waitNs / 1e6 << "ms na fila");
+    else
+        LOG_DEBUG("[COORDENADOR] Garfo " << forkId << " concedido ao filósofo " << grant.philosopherId);
 }
 
-// Cria um socket para se conectar à porta e endereço especificados para envio de mensagens
-void Coordinator::sendMessage(int port, const std::string& data) {
-    int sock = socket(AF_INET, SOCK_STREAM, 0);
-    if (sock < 0) {
-        perror("socket creation failed");
+// Os dois garfos do filósofo 'i' são o 'i' (esquerdo, informado na mensagem) e o seguinte no anel.
+// Pedidos de pares e de garfos individuais não podem ser misturados, então o pedido só é aceito com acquire_mode=pair
+void Coordinator::handleAcquirePair(int fromId, int forkId) {
+    if (fromId < 0 || fromId >= config.numPhilosophers || forkId != fromId || config.acquireMode != AcquireMode::PAIR) {
+        LOG_WARN("[COORDENADOR] Pedido de par inválido do filósofo " << fromId << " pelos garfos " << forkId << ". Ignorando.");
         return;
     }
-    sockaddr_in addr{};
-    addr.sin_family = AF_INET;
-    addr.sin_port = htons(port);
-    if (inet_pton(AF_INET, LOCALHOST, &addr.sin_addr) <= 0) {
-        perror("Invalid address/ Address not supported");
-        close(sock);
-        return;
+    count(Counter::FORK_REQUESTS);
+    ForkTable::Grant grant = forks.acquirePair(forkId, (forkId + 1) % config.numPhilosophers, fromId);
+    if (grant.granted()) {
+        grantPair(grant);
+    } else {
+        LOG_DEBUG("[COORDENADOR] Filósofo " << fromId << " solicitou os garfos " << forkId << " e " << (forkId + 1) % config.numPhilosophers
+                  << ", mas não estão disponíveis. Aguardando nas filas.");
     }
+}
 
-    if (connect(sock, (sockaddr*)&addr, sizeof(addr)) < 0) {
-        close(sock);
-        return;
+// Cada garfo liberado pode completar o par de um dos vizinhos, que recebe os dois garfos de uma vez
+void Coordinator::handleReleasePair(int fromId, int forkId) {
+    std::vector<ForkTable::Grant> next;
+    if (fromId >= 0 && fromId < config.numPhilosophers && forkId == fromId &&
+        forks.releasePair(forkId, (forkId + 1) % config.numPhilosophers, fromId, next)) {
+        count(Counter::FORK_RELEASES);
+        LOG_DEBUG("[COORDENADOR] Garfos " << forkId << " e " << (forkId + 1) % config.numPhilosophers << " liberados pelo filósofo " << fromId);
+        for (const ForkTable::Grant& grant : next) {
+            grantPair(grant);
+        }
+    } else {
+        LOG_WARN("[COORDENADOR] Filósofo " << fromId << " tentou liberar os garfos " << forkId << ", que não são seus. Ignorando.");
+    }
+}
+
+// Envia o PAIR_GRANTED ao filósofo que recebeu os dois garfos
+void Coordinator::grantPair(const ForkTable::Grant& grant) {
+    sendMessage(grant.philosopherId, Message{ MessageType::PAIR_GRANTED, id, grant.philosopherId });
+    count(Counter::FORK_GRANTS);
+    meals[grant.philosopherId].fetch_add(1, std::memory_order_relaxed);
+    record(Histogram::FORK_GRANT_WAIT_NS, grant.waitNs);
+    LOG_DEBUG("[COORDENADOR] Garfos " << grant.philosopherId << " e " << (grant.philosopherId + 1) % config.numPhilosophers
+              << " concedidos ao filósofo " << grant.philosopherId << " após " << grant.waitNs / 1e6 << "ms na fila");
+}
+
+// As conexões de saída são distribuídas entre os laços de eventos pela porta de destino
+Reactor& Coordinator::reactorFor(int port) {
+    return *reactors[port % reactors.size()];
+}
+
+// Codifica a mensagem com o destinatário e a coloca na fila de saída da conexão com a porta em que ele escuta
+// (ou a entrega ao transporte próprio). Não bloqueia: a escrita no socket é feita pelo laço de eventos
+// Mensagens sem conteúdo são codificadas na pilha, sem alocação
+void Coordinator::sendMessage(int targetId, Message msg) {
+    msg.targetId = targetId;
+    int port = config.participantPort(targetId);
+    char buffer[MESSAGE_HEADER_SIZE];
+    std::string serialized;
+    std::string_view data;
+    if (msg.content.empty()) {
+        data = std::string_view(buffer, msg.encode(buffer));
+    } else {
+        serialized = msg.serialize();
+        data = serialized;
     }
-    send(sock, data.c_str(), data.size(), 0);
-    close(sock);
+    if (transport) transport->send(port, data);
+    else reactorFor(port).sendTo(port, data);
 }
 
 // Envia uma mensagem do tipo Marker para os filósofos, indicando o acontecimento do snapshot
 // Dessa form os filósofos deverão mandar seues estados para o coordenador
-void Coordinator::initiateSnapshot() {
-    std::cout << "\n[COORDENADOR] Iniciando snapshot...\n" << std::flush;
-    Message marker{ MessageType::MARKER, id, "" };
+// Com vários fragmentos, o marcador também vai para os demais fragmentos, que o repassam pelos seus próprios canais com os filósofos
+void Coordinator::initiateSnapshot(uint32_t epoch) {
+    LOG_INFO("[COORDENADOR] Iniciando snapshot " << epoch << "...");
+    Message marker{ MessageType::MARKER, id };
+    marker.epoch = epoch;
+
+    for (int s = 1; s < config.coordinatorShards; ++s) {
+        sendMessage(coordinatorId(s), marker);
+    }
+    for (int i = 0; i < config.numPhilosophers; ++i) {
+        LOG_DEBUG("[COORDENADOR] Enviando marcador para filósofo " << i << " na porta " << config.philosopherPort(i));
+        sendMessage(i, marker);
+    }
+}
 
-    for (int i = 0; i < NUM_PHILOSOPHERS; ++i) {
-        std::cout << "[COORDENADOR] Enviando marcador para filósofo " << i << " na porta " << BASE_PORT + i << "\n" << std::flush;
-        sendMessage(BASE_PORT + i, marker.serialize());
+// Cada fragmento é um canal de entrada de cada filósofo: o filósofo só termina o seu snapshot quando recebe o marcador de todos,
+// e as concessões enviadas pelo fragmento antes do marcador e ainda não recebidas ficam gravadas como mensagens em trânsito
+void Coordinator::forwardMarker(uint32_t epoch) {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (epoch <= lastForwardedEpoch) return;
+        lastForwardedEpoch = epoch;
+    }
+    LOG_DEBUG("[COORDENADOR] Repassando o marcador do snapshot " << epoch << " aos filósofos");
+    printStats();
+    Message marker{ MessageType::MARKER, id };
+    marker.epoch = epoch;
+    for (int i = 0; i < config.numPhilosophers; ++i) {
+        sendMessage(i, marker);
     }
 }
 
-// Adiquire um lock para proteger o Mapa "napshots".
-// Armazena os dados recebidos do snapshot, caso o filósofo não tenha mandado ainda na interação atual
-// Se todos os filósofos tiverem enviado o seu snapshot, chama a função para analisá-los e imprimir eles
-void Coordinator::handleSnapshot(int fromId, const std::string& content) {
+// Adiquire um lock para proteger as rodadas de snapshot.
+// Armazena os dados recebidos do snapshot na rodada da época, caso o filósofo não tenha mandado ainda nessa rodada
+// Se todos os filósofos tiverem enviado o seu snapshot da rodada, chama a função para analisá-los e imprimir eles e encerra a rodada
+// Os dados são copiados para a arena da rodada e decodificados uma única vez, com as mensagens em trânsito apontando para a cópia
+void Coordinator::handleSnapshot(int fromId, uint32_t epoch, std::string_view content) {
     std::lock_guard<std::mutex> lock(mtx);
-    if (snapshots.find(fromId) == snapshots.end()) {
-        snapshots[fromId] = content;
-        std::cout << "[COORDENADOR] Recebeu snapshot do filósofo " << fromId << ". (Total: " << snapshots.size() << "/" << NUM_PHILOSOPHERS << ")\n" << std::flush;
-    } else {
-        std::cout << "[COORDENADOR] Recebeu snapshot DUPLICADO do filósofo " << fromId << ". Ignorando.\n" << std::flush;
+    if (fromId < 0 || fromId >= config.numPhilosophers) {
+        LOG_WARN("[COORDENADOR] Snapshot de filósofo desconhecido " << fromId << ". Ignorando.");
+        return;
     }
-
-    if (snapshots.size() == NUM_PHILOSOPHERS) {
-        std::cout << "[COORDENADOR] Recebeu todos os snapshots. Imprimindo e detectando deadlock.\n" << std::flush;
-        printSnapshot();
+    auto it = rounds.find(epoch);
+    if (it == rounds.end()) {
+        LOG_DEBUG("[COORDENADOR] Recebeu snapshot do filósofo " << fromId << " da rodada " << epoch << ", que não está em andamento. Ignorando.");
+        // O estado local ainda é a referência dos próximos snapshots sem conteúdo do filósofo
+        if (config.aggregationFanout == 0 && !content.empty() &&
+            SnapshotView::decodeLocalState(content, lastSnapshots[fromId]))
+            hasLastSnapshot[fromId] = true;
+        return;
+    }
+    SnapshotRound& round = it->second;
+    if (round.received[fromId]) {
+        LOG_WARN("[COORDENADOR] Recebeu snapshot " << epoch << " DUPLICADO do filósofo " << fromId << ". Ignorando.");
+        return;
+    }
+    std::string_view data = round.arena->copy(content);
+    if (config.aggregationFanout > 0) {
+        round.summaries[fromId] = data;
+    } else if (!decodeSnapshot(fromId, data, *round.arena, round.snapshots[fromId])) {
+        return;
+    }
+    round.received[fromId] = true;
+    size_t received = ++round.receivedCount;
+    LOG_DEBUG("[COORDENADOR] Recebeu snapshot " << epoch << " do filósofo " << fromId << ". (Total: " << received << "/" << expectedSnapshots << ")");
+
+    if (received == expectedSnapshots) {
+        LOG_INFO("[COORDENADOR] Recebeu todos os snapshots da rodada " << epoch << ". Imprimindo e detectando deadlock.");
+        record(Histogram::SNAPSHOT_ROUND_NS, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - it->second.startedAt).count());
+        count(Counter::SNAPSHOTS_COMPLETED);
+        if (config.aggregationFanout > 0) printSummary(epoch, it->second);
+        else printSnapshot(epoch, it->second);
+        endRound(it);
     }
 }
 
-// Função recursiva para detectar um ciclo em grafo (Algorítimo DFS)
-bool hasCycle(int startNode, std::map<int, std::vector<int>>& adj, std::set<int>& visited, std::set<int>& recursionStack) {
-    // Marca nó como visitado
-    visited.insert(startNode);
-    // Adiciona nó na pilha de recursão
-    recursionStack.insert(startNode);
-
-    // Itera sobre vizinhos do nó atual
-    if (adj.count(startNode)) {
-        for (int neighbor : adj[startNode]) {
-            // Se o vizinho não foi visitado
-            if (!visited.count(neighbor)) {
-                //Chama DFS recursivamente para o vizinho
-                if (hasCycle(neighbor, adj, visited, recursionStack)) {
-                    // Ciclo determinado
-                    return true;
-                }
-            } 
-            // Se o vizinho está na pilha de recursão há ciclo
-            else if (recursionStack.count(neighbor)) {
-                std::cout << "  [DEBUG DFS] Ciclo detectado: " << startNode << " -> ... -> " << neighbor << "\n" << std::flush;
-                return true; // Ciclo detectado
-            }
+// Chamada com o lock "mtx" adquirido.
+// As mensagens de cada filósofo chegam na ordem de envio, então o último estado local recebido é o mesmo que o filósofo usou como referência
+bool Coordinator::decodeSnapshot(int fromId, std::string_view content, Arena& arena, SnapshotView& snap) {
+    if (content.empty()) {
+        if (!hasLastSnapshot[fromId]) {
+            LOG_WARN("Filósofo " << fromId << ": snapshot sem conteúdo antes de qualquer snapshot completo. Ignorando.");
+            return false;
         }
+        snap = lastSnapshots[fromId];
+        return true;
+    }
+    if (!SnapshotView::decode(content, snap, arena)) {
+        LOG_WARN("Filósofo " << fromId << ": snapshot inválido. Ignorando.");
+        return false;
     }
-    // Remove o nó da pilha ao sair da chamada e retorna como nenhum ciclo detectado
-    recursionStack.erase(startNode);
-    return false;
+    lastSnapshots[fromId] = snap;
+    lastSnapshots[fromId].channels = nullptr;
+    lastSnapshots[fromId].channelCount = 0;
+    hasLastSnapshot[fromId] = true;
+    return true;
 }
 
-// Deserializa os dados do snapshot
+// Os vetores da rodada são alocados na arena, com um elemento por filósofo
+Coordinator::SnapshotRound& Coordinator::beginRound(uint32_t epoch) {
+    SnapshotRound& round = rounds[epoch];
+    round.startedAt = std::chrono::steady_clock::now();
+    if (arenaPool.empty()) {
+        round.arena = std::make_unique<Arena>();
+    } else {
+        round.arena = std::move(arenaPool.back());
+        arenaPool.pop_back();
+    }
+    round.received = round.arena->allocateArray<bool>(config.numPhilosophers);
+    if (config.aggregationFanout > 0) round.summaries = round.arena->allocateArray<std::string_view>(config.numPhilosophers);
+    else round.snapshots = round.arena->allocateArray<SnapshotView>(config.numPhilosophers);
+    return round;
+}
+
+// Todos os snapshots, mensagens e dados recebidos da rodada são liberados de uma vez ao reiniciar a arena
+void Coordinator::endRound(std::map<uint32_t, SnapshotRound>::iterator it) {
+    it->second.arena->reset();
+    arenaPool.push_back(std::move(it->second.arena));
+    rounds.erase(it);
+}
+
+// Percorre os snapshots já decodificados na arena da rodada
 // Constói um grafo de espera analisando os etados dos filósofos e a posse dos garfos
-// Utiliza a função "hasCycle" para verificar o acontecimento de deadlock
-void Coordinator::printSnapshot() {
-    std::cout << "\n=== SNAPSHOT COMPLETO ===\n" << std::flush;
-    // Mapa para armazenar snapshot
-    std::map<int, Snapshot> parsedSnapshots;
-    // Mapa para indicar filósofos que possuem garfos
-    std::map<int, int> forkOwner; 
-    // Mapa para indicar filósofos que etão esperando por garfos
-    std::map<int, std::vector<int>> waitForGraph;
-
-    // Deserializa e imprimes os dados dos snapshots da cada filósofos
-    for (const auto& [id, snap_str] : snapshots) {
-        Snapshot s = Snapshot::deserialize(snap_str);
-        parsedSnapshots[id] = s;
-
-        std::cout << "Filósofo " << id
-                  << ": Estado=" << s.localState
+// Utiliza o detector de componentes fortemente conexas para encontrar todos os conjuntos de filósofos em deadlock
+void Coordinator::printSnapshot(uint32_t epoch, const SnapshotRound& round) {
+    double durationMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - round.startedAt).count();
+    LOG_INFO("=== SNAPSHOT " << epoch << " COMPLETO (" << durationMs << " ms) ===");
+    // Arestas do grafo de espera (filósofo que espera, dono do garfo) e donos dos garfos, reaproveitados entre snapshots
+    waitEdges.clear();
+    forkOwner.assign(config.numPhilosophers, -1);
+    auto ownerOf = [this](int forkId) { return forkId >= 0 && forkId < config.numPhilosophers ? forkOwner[forkId] : -1; };
+
+    // Imprime os dados dos snapshots da cada filósofos
+    for (int id = 0; id < config.numPhilosophers; ++id) {
+        if (!round.received[id]) continue;
+        const SnapshotView& s = round.snapshots[id];
+        LOG_INFO("Filósofo " << id
+                  << ": Estado=" << stateName(s.localState)
                   << ", Possui Esquerda=" << (s.hasLeftFork ? "Sim" : "Não")
                   << ", Possui Direita=" << (s.hasRightFork ? "Sim" : "Não")
                   << ", Garfo Esquerdo ID=" << s.leftForkId
-                  << ", Garfo Direito ID=" << s.rightForkId << "\n" << std::flush;
+                  << ", Garfo Direito ID=" << s.rightForkId);
          // Imprime as mensagens em trânsito para cada filósofo
-        for (const auto& [from, msgs_serialized] : s.channelMessages) {
-            for (const std::string& msg_str : msgs_serialized) {
-                Message m = Message::deserialize(msg_str);
-                std::cout << "  Mensagem em trânsito (de " << m.senderId << " para " << id << "): Tipo=";
-                if (m.type == MessageType::REQUEST_FORK) std::cout << "REQUEST_FORK";
-                else if (m.type == MessageType::RELEASE_FORK) std::cout << "RELEASE_FORK";
-                else if (m.type == MessageType::FORK_GRANTED) std::cout << "FORK_GRANTED";
-                else if (m.type == MessageType::MARKER) std::cout << "MARKER";
-                else if (m.type == MessageType::SNAPSHOT_DATA) std::cout << "SNAPSHOT_DATA";
-                else std::cout << "UNKNOWN";
-                std::cout << ", Conteúdo=" << m.content << "\n" << std::flush;
+        for (const SnapshotView::Channel& channel : s) {
+            record(Histogram::IN_TRANSIT_PER_CHANNEL, channel.count);
+            count(Counter::IN_TRANSIT_MESSAGES, channel.count);
+            for (const MessageView& m : channel) {
+                LOG_INFO("  Mensagem em trânsito (de " << m.senderId << " para " << id << "): Tipo=" << messageTypeName(m.type)
+                          << ", Garfo=" << m.forkId);
             }
         }
     }
-    // Atualiazando o Mapa "forkOwner" com base na posse de garfos
-    for (const auto& [id, s] : parsedSnapshots) {
-        if (s.hasLeftFork) {
-            forkOwner[s.leftForkId] = id;
-        }
-        if (s.hasRightFork) {
-            forkOwner[s.rightForkId] = id;
+    // Atualiazando o vetor "forkOwner" com base na posse de garfos (sem os garfos revogados em trânsito pelo coordenador)
+    auto holds = [this](const SnapshotView& s, int forkId) { return s.holdsFork(coordinatorId(config.forkShard(forkId)), forkId); };
+    for (int id = 0; id < config.numPhilosophers; ++id) {
+        if (!round.received[id]) continue;
+        const SnapshotView& s = round.snapshots[id];
+        for (int forkId : { s.leftForkId, s.rightForkId }) {
+            if (forkId >= 0 && forkId < config.numPhilosophers && holds(s, forkId)) forkOwner[forkId] = id;
         }
     }
     // Constrói o grafo de espera para a detecção de deadlock
-    for (const auto& [id, s] : parsedSnapshots) {
-        if (s.localState == "hungry") {
-            if (!s.hasLeftFork) {
-                bool forkLeftGrantedInTransit = false;
-                if (forkOwner.count(s.leftForkId)) { 
-                    int potentialOwnerId = forkOwner[s.leftForkId];
-                    if (parsedSnapshots.count(potentialOwnerId) && s.channelMessages.count(potentialOwnerId)) {
-                        for (const std::string& msg_str : s.channelMessages.at(potentialOwnerId)) {
-                            Message m = Message::deserialize(msg_str);
-                            if (m.type == MessageType::FORK_GRANTED && std::stoi(m.content) == s.leftForkId) {
-                                forkLeftGrantedInTransit = true;
-                                break;
-                            }
-                        }
-                    }
-                }
-
-                if (!forkLeftGrantedInTransit) {
-                    if (forkOwner.count(s.leftForkId)) {
-                        int ownerId = forkOwner[s.leftForkId];
-                        if (parsedSnapshots.count(ownerId) && parsedSnapshots[ownerId].localState == "hungry") {
-                            waitForGraph[id].push_back(ownerId);
-                            std::cout << "  [Grafo] Filósofo " << id << " espera pelo garfo " << s.leftForkId << " (possuído por " << ownerId << ")\n" << std::flush;
-                        }
-                    }
-                }
+    for (int id = 0; id < config.numPhilosophers; ++id) {
+        if (!round.received[id] || round.snapshots[id].localState != PhilosopherState::HUNGRY) continue;
+        const SnapshotView& s = round.snapshots[id];
+        for (int forkId : { s.leftForkId, s.rightForkId }) {
+            if (holds(s, forkId)) continue;
+            int ownerId = ownerOf(forkId);
+            // Concessões de garfos são enviadas pelo fragmento do coordenador que arbitra o garfo
+            if (ownerId < 0 || s.grantedInTransit(coordinatorId(config.forkShard(forkId)), forkId)) continue;
+            if (round.received[ownerId] && round.snapshots[ownerId].localState == PhilosopherState::HUNGRY) {
+                waitEdges.emplace_back(id, ownerId);
+                LOG_INFO("  [Grafo] Filósofo " << id << " espera pelo garfo " << forkId << " (possuído por " << ownerId << ")");
             }
+        }
+    }
 
-            if (!s.hasRightFork) {
-                bool forkRightGrantedInTransit = false;
-                if (forkOwner.count(s.rightForkId)) {
-                    int potentialOwnerId = forkOwner[s.rightForkId];
-                    if (parsedSnapshots.count(potentialOwnerId) && s.channelMessages.count(potentialOwnerId)) {
-                        for (const std::string& msg_str : s.channelMessages.at(potentialOwnerId)) {
-                            Message m = Message::deserialize(msg_str);
-                            if (m.type == MessageType::FORK_GRANTED && std::stoi(m.content) == s.rightForkId) {
-                                forkRightGrantedInTransit = true;
-                                break;
-                            }
-                        }
-                    }
-                }
-
-                if (!forkRightGrantedInTransit) {
-                    if (forkOwner.count(s.rightForkId)) {
-                        int ownerId = forkOwner[s.rightForkId];
-                        if (parsedSnapshots.count(ownerId) && parsedSnapshots[ownerId].localState == "hungry") {
-                            waitForGraph[id].push_back(ownerId);
-                            std::cout << "  [Grafo] Filósofo " << id << " espera pelo garfo " << s.rightForkId << " (possuído por " << ownerId << ")\n" << std::flush;
-                        }
-                    }
-                }
-            }
+    detectDeadlock();
+}
+
+// No modo de agregação, cada filho da raiz envia o grafo de espera parcial da sua subárvore, em vez dos snapshots completos.
+// Os resumos são juntados e as esperas que cruzam subárvores são resolvidas; o restante da detecção é igual ao dos snapshots completos
+void Coordinator::printSummary(uint32_t epoch, const SnapshotRound& round) {
+    double durationMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - round.startedAt).count();
+    LOG_INFO("=== SNAPSHOT " << epoch << " AGREGADO COMPLETO (" << durationMs << " ms) ===");
+
+    PartialGraph merged;
+    for (int child = 0; child < config.numPhilosophers; ++child) {
+        if (!round.received[child]) continue;
+        PartialGraph graph;
+        if (!PartialGraph::decode(round.summaries[child], graph)) {
+            LOG_WARN("Resumo inválido da subárvore do filósofo " << child << ". Ignorando.");
+            continue;
         }
+        merged.merge(graph);
+    }
+    // Na raiz todos os filósofos estão cobertos: as esperas sem dono conhecido são por garfos livres
+    merged.resolve([](int) { return true; });
+
+    LOG_INFO("Filósofos cobertos=" << merged.philosophers << "/" << config.numPhilosophers
+              << ", Famintos=" << merged.hungry << ", Arestas=" << merged.edges.size());
+    waitEdges.assign(merged.edges.begin(), merged.edges.end());
+    for (const auto& [waiter, owner] : waitEdges) {
+        LOG_INFO("  [Grafo] Filósofo " << waiter << " espera por um garfo possuído por " << owner);
     }
 
-    // Verifica se há deadlock
-    bool deadlockDetectedThisSnapshot = false;
-    std::set<int> visitedNodes;
-    std::set<int> recursionStack;
+    detectDeadlock();
+}
 
-    for (const auto& [philosopherId, _] : parsedSnapshots) {
-        if (parsedSnapshots[philosopherId].localState == "hungry" && !visitedNodes.count(philosopherId)) {
-            std::cout << "  [DEBUG DFS] Iniciando DFS do filósofo " << philosopherId << "\n" << std::flush;
-            if (hasCycle(philosopherId, waitForGraph, visitedNodes, recursionStack)) {
-                deadlockDetectedThisSnapshot = true;
-                break;
-            }
+void Coordinator::detectDeadlock() {
+    // Verifica se há deadlock: cada componente fortemente conexa com ciclo é um conjunto de filósofos em deadlock
+    waitGraphCsr.build(config.numPhilosophers, waitEdges);
+    bool deadlockDetectedThisSnapshot = cycleDetector.run(waitGraphCsr) > 0;
+    for (size_t i = 0; i < cycleDetector.cycleCount(); ++i) {
+        auto [begin, end] = cycleDetector.cycle(i);
+        if (!logEnabled(LogLevel::WARN)) break;
+        // Ciclos grandes continuam em outras linhas, cada uma com o índice do ciclo
+        const int* member = begin;
+        for (bool first = true; first || member != end; first = false) {
+            LogLine line(LogLevel::WARN);
+            line << "  [Ciclo " << i << "] ";
+            if (first) line << (end - begin) << " filósofos:";
+            else line << "(continuação):";
+            while (member != end && line.remaining() > MAX_ID_DIGITS) line << " " << *member++;
         }
     }
 
     // Atualiza a flag de deadlock do coordenador e imprime o resultado
     if (deadlockDetectedThisSnapshot) {
-        std::cout << "\n!!! DEADLOCK DETECTADO !!!\n" << std::flush;
+        LOG_WARN("!!! DEADLOCK DETECTADO !!!");
         this->deadlockDetected = true;
+        count(Counter::DEADLOCKS_DETECTED);
     } else {
-        std::cout << "\nNenhum deadlock detectado neste snapshot.\n" << std::flush;
+        LOG_INFO("Nenhum deadlock detectado neste snapshot.");
         this->deadlockDetected = false;
     }
 
-    std::cout << "===========================\n" << std::flush;
+    // Verificação cruzada com o grafo de espera incremental. Deadlock é uma propriedade estável:
+    // se o snapshot (um corte consistente do passado) contém um ciclo, o grafo atual também precisa conter.
+    // Com vários fragmentos, o grafo incremental de cada um só tem as esperas pelos seus garfos, e a verificação não se aplica
+    if (config.coordinatorShards > 1) {
+        LOG_INFO("===========================");
+        return;
+    }
+    std::vector<int> liveCycle = waitGraph.findCycle();
+    if (deadlockDetectedThisSnapshot && liveCycle.empty()) {
+        LOG_ERROR("[COORDENADOR] DIVERGÊNCIA: o snapshot indica deadlock, mas o grafo de espera incremental não possui ciclo.");
+    } else if (!deadlockDetectedThisSnapshot && !liveCycle.empty()) {
+        LOG_INFO("[COORDENADOR] O grafo de espera incremental possui um ciclo formado após o corte do snapshot.");
+    } else {
+        LOG_INFO("[COORDENADOR] Snapshot consistente com o grafo de espera incremental (" << waitGraph.edgeCount() << " arestas).");
+    }
+
+    // Com o resultado conferido, desfaz os deadlocks encontrados (apenas sem fragmentos: os garfos de um ciclo são todos deste coordenador)
+    if (deadlockDetectedThisSnapshot && config.deadlockResolution != DeadlockResolution::OFF) {
+        for (size_t i = 0; i < cycleDetector.cycleCount(); ++i) {
+            auto [begin, end] = cycleDetector.cycle(i);
+            resolveDeadlock(begin, end);
+        }
+    }
+
+    LOG_INFO("===========================");
 }
 
 
-// Cria uma instância da classe Coordinator e a inicia.
-int main(int argc, char* argv[]) {
-    Coordinator coordinator;
-    coordinator.start();
-    return 0;
-}
\ No newline at end of file
+// Chamada com o lock "mtx" adquirido. O snapshot é um corte do passado, então o ciclo é conferido na tabela de garfos:
+// ele só continua em deadlock se cada membro ainda possui um garfo e espera pelo outro, possuído por outro membro.
+// Um ciclo já desfeito (por exemplo, por uma revogação após uma rodada anterior) é ignorado.
+// A vítima perde o garfo que possui, que é passado ao primeiro da fila dele (um membro do ciclo); ela continua na fila do
+// outro garfo e volta a pedir o garfo revogado ao receber o PREEMPT. O tempo de recuperação é medido desde o pedido
+// mais recente do ciclo, que foi o que o fechou
+void Coordinator::resolveDeadlock(const int* begin, const int* end) {
+    std::set<int> members(begin, end);
+    int victim = -1, heldFork = -1, waitedFork = -1;
+    ForkTable::Clock::time_point victimSince, formedAt;
+    uint64_t victimMeals = 0;
+    for (const int* member = begin; member != end; ++member) {
+        int philosopherId = *member;
+        int left = philosopherId, right = (philosopherId + 1) % config.numPhilosophers;
+        int held = forks.owner(left) == philosopherId ? left : right;
+        int waited = held == left ? right : left;
+        ForkTable::Clock::time_point since;
+        if (forks.owner(held) != philosopherId || !forks.waitingSince(waited, philosopherId, since) || !members.count(forks.owner(waited))) {
+            LOG_INFO("[COORDENADOR] O ciclo do filósofo " << philosopherId << " já foi desfeito. Nenhum garfo revogado.");
+            return;
+        }
+        formedAt = std::max(formedAt, since);
+        uint64_t philosopherMeals = meals[philosopherId].load(std::memory_order_relaxed);
+        bool better = victim < 0 || since > victimSince;
+        if (config.deadlockResolution == DeadlockResolution::FEWEST_MEALS && victim >= 0)
+            better = philosopherMeals < victimMeals || (philosopherMeals == victimMeals && since > victimSince);
+        if (better) {
+            victim = philosopherId;
+            heldFork = held;
+            waitedFork = waited;
+            victimSince = since;
+            victimMeals = philosopherMeals;
+        }
+    }
+
+    ForkTable::Grant next;
+    if (victim < 0 || !forks.preempt(heldFork, victim, waitedFork, next)) return;
+    auto now = ForkTable::Clock::now();
+    sendMessage(victim, Message{ MessageType::PREEMPT, id, heldFork });
+    count(Counter::DEADLOCKS_RESOLVED);
+    record(Histogram::DEADLOCK_RECOVERY_NS, std::chrono::duration_cast<std::chrono::nanoseconds>(now - formedAt).count());
+    double victimWaitMs = std::chrono::duration<double, std::milli>(now - victimSince).count();
+    double recoveryMs = std::chrono::duration<double, std::milli>(now - formedAt).count();
+    LOG_WARN("[COORDENADOR] Deadlock desfeito: garfo " << heldFork << " revogado do filósofo " << victim
+              << " (refeições=" << victimMeals << ", esperando há " << victimWaitMs << "ms), formado há " << recoveryMs << "ms");
+    if (next.granted()) {
+        grantFork(heldFork, next);
+    }
+}
+
+// Chamada pela thread de E/S que fez a mudança que fechou o ciclo, no momento em que o pedido ou a liberação foi processado
+// Ciclos grandes continuam em outras linhas
+void Coordinator::onLiveDeadlock(const std::vector<int>& cycle) {
+    if (!logEnabled(LogLevel::WARN)) return;
+    size_t next = 0;
+    for (bool first = true; first || next <= cycle.size(); first = false) {
+        LogLine line(LogLevel::WARN);
+        line << (first ? "!!! DEADLOCK DETECTADO (grafo de espera incremental): " : "  (continuação): ");
+        for (; next < cycle.size() && line.remaining() > MAX_ID_DIGITS + 4; ++next) line << cycle[next] << " -> ";
+        if (next == cycle.size() && line.remaining() > MAX_ID_DIGITS + 4) {
+            line << cycle.front() << " !!!";
+            ++next;
+        }
+    }
+}
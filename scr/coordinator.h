@@ -1,6 +1,7 @@
 #ifndef COORDINATOR_H
 #define COORDINATOR_H
 
+#include <atomic>
 #include <map>
 #include <mutex>
 #include <string>
@@ -20,43 +21,127 @@
 #include "message.h"
 #include "config.h"
 #include "snapshot.h"
+#include "reactor.h"
+#include "fork_table.h"
+#include "wait_for_graph.h"
+#include "cycle_detector.h"
+#include "partial_graph.h"
+#include "metrics.h"
+#include "transport.h"
+#include "arena.h"
 
 // Definição da classe Coordinator
 class Coordinator {
 public:
-    // Construtor da classe
-    Coordinator();
+    // Construtor da classe, recebendo a configuração do cluster e o índice do fragmento ("coordinator_shards"):
+    // o fragmento só arbitra os garfos f com f % coordinator_shards == shard, e o fragmento 0 também coordena os snapshots.
+    // Sem "transport", as mensagens são trocadas pelos laços de eventos das threads de E/S (TCP).
+    // Com ele, uma única thread recebe as mensagens pelo transporte (memória compartilhada, ou os canais do simulador)
+    explicit Coordinator(const Config& config, int shard = 0, Transport* transport = nullptr);
     // Função para inicializar o coordenador (criar as threads)
     void start();
+    // Inicia uma nova rodada de snapshot. Chamada periodicamente pelo "runLoop" do fragmento 0 ou pelo simulador
+    void startSnapshotRound();
+    // Despacha uma mensagem recebida para a função correspondente
+    void dispatch(std::string_view data);
 
 private:
-    // Mutex para proteção da região crítica
+    // Configuração do cluster
+    Config config;
+    // Mutex para proteção dos dados do snapshot (os garfos não dependem dele)
     std::mutex mtx;
-    // Mapa para indicar disponibilidade de um determinado garfo (True = Disponível, False = Ocupado)
-    std::map<int, bool> forkAvailable; 
-    // Mapa para armazenar o snpashot de cada filósofo
-    std::map<int, std::string> snapshots; 
+    // Grafo de espera atualizado a cada pedido e liberação de garfo
+    WaitForGraph waitGraph;
+    // Tabela de posse dos garfos, acessada sem lock pelas threads de E/S
+    ForkTable forks;
+    // Rodada de snapshot em andamento
+    struct SnapshotRound {
+        // Instante em que os marcadores foram enviados
+        std::chrono::steady_clock::time_point startedAt;
+        // Arena com tudo o que a rodada recebe: os dados recebidos, os snapshots decodificados sobre eles e os vetores abaixo.
+        // Devolvida ao "arenaPool" (e reiniciada, em O(1)) quando a rodada termina
+        std::unique_ptr<Arena> arena;
+        // Vetores indexados pelo ID do filósofo: se o seu snapshot (ou o seu resumo, no modo de agregação) já foi recebido,
+        // o snapshot decodificado (repetido do último recebido quando enviado sem conteúdo) e o resumo ainda codificado
+        bool* received = nullptr;
+        SnapshotView* snapshots = nullptr;
+        std::string_view* summaries = nullptr;
+        size_t receivedCount = 0;
+    };
+    // Rodadas em andamento, indexadas pela época. Várias rodadas podem se sobrepor
+    std::map<uint32_t, SnapshotRound> rounds;
+    // Arenas das rodadas encerradas, reaproveitadas pelas próximas
+    std::vector<std::unique_ptr<Arena>> arenaPool;
+    // Época da próxima rodada
+    uint32_t nextEpoch = 1;
+    // Estado local do último snapshot recebido de cada filósofo (sem as mensagens em trânsito), repetido quando o filósofo
+    // envia um snapshot sem conteúdo ("delta_snapshots"), e se algum já foi recebido
+    std::vector<SnapshotView> lastSnapshots;
+    std::vector<bool> hasLastSnapshot;
+    // Número de mensagens que completam uma rodada: um snapshot por filósofo ou, no modo de agregação, um resumo por filho da raiz
+    size_t expectedSnapshots;
     // Flag para identificar a detecção de um deadlock
     bool deadlockDetected;
-    // Id do coordenador
+    // Grafo de espera montado a partir do snapshot e o detector de ciclos, reaproveitados entre snapshots
+    std::vector<std::pair<int, int>> waitEdges;
+    // Dono de cada garfo no snapshot em análise (-1 quando nenhum filósofo o possui), reaproveitado entre snapshots
+    std::vector<int> forkOwner;
+    CsrGraph waitGraphCsr;
+    CycleDetector cycleDetector;
+    // Refeições de cada filósofo vistas pelo coordenador (concessões que completam os dois garfos), usadas na escolha de vítimas
+    std::unique_ptr<std::atomic<uint64_t>[]> meals;
+    // Índice do fragmento e id do coordenador (coordinatorId(shard))
+    int shard;
     int id;
+    // Última época cujo marcador foi repassado aos filósofos por um fragmento que não inicia os snapshots
+    uint32_t lastForwardedEpoch = 0;
+    // Laços de eventos que atendem as conexões com os filósofos, um por thread de E/S
+    std::vector<std::unique_ptr<Reactor>> reactors;
+    // Transporte usado no lugar dos laços de eventos, quando fornecido no construtor
+    Transport* transport = nullptr;
 
     // Loop principal do coordenador
     void runLoop();
-    // Loop de escuta do coordenador
-    void listenLoop();
+    // Loop de escuta de uma thread de E/S do coordenador
+    void listenLoop(Transport& receiver);
+    // Retorna o laço de eventos responsável pelas conexões de saída com a porta especificada
+    Reactor& reactorFor(int port);
     // Função para cuidar dos pedidos de garfos por filósofos
     void handleRequest(int fromId, int forkId);
     // Função para cuidar da liberação de garfos por filósofos
     void handleRelease(int fromId, int forkId);
-    // Função para cuidar dos envios de mensagens
-    void sendMessage(int port, const std::string& data);
-    // Função para iniciar o processo de tirar o snapshot
-    void initiateSnapshot();
+    // Envia a mensagem de concessão do garfo ao filósofo
+    void grantFork(int forkId, const ForkTable::Grant& grant);
+    // Modo "acquire_mode=pair": pedido e liberação dos dois garfos do filósofo, e a concessão dos dois juntos
+    void handleAcquirePair(int fromId, int forkId);
+    void handleReleasePair(int fromId, int forkId);
+    void grantPair(const ForkTable::Grant& grant);
+    // Função para cuidar dos envios de mensagens ao filósofo (ou fragmento do coordenador) especificado
+    void sendMessage(int targetId, Message msg);
+    // Imprime as estatísticas das conexões e das filas de garfos
+    void printStats();
+    // Função para iniciar o processo de tirar o snapshot da época especificada
+    void initiateSnapshot(uint32_t epoch);
+    // Repassa aos filósofos o marcador de uma época recebido do fragmento 0
+    void forwardMarker(uint32_t epoch);
     // Função que cuidará da análise dos dados recebidos pelo snapshot
-    void handleSnapshot(int fromId, const std::string& content);
-    // Função para imprimir os resultados coletados e realizar a detecção de deadlock
-    void printSnapshot();
+    void handleSnapshot(int fromId, uint32_t epoch, std::string_view content);
+    // Decodifica na arena o snapshot do filósofo e guarda o seu estado local como o último recebido.
+    // Um snapshot sem conteúdo repete o último estado local recebido. Retorna falso se o snapshot for inválido
+    bool decodeSnapshot(int fromId, std::string_view content, Arena& arena, SnapshotView& snap);
+    // Cria a rodada da época, com uma arena do "arenaPool", e encerra uma rodada, devolvendo a sua arena
+    SnapshotRound& beginRound(uint32_t epoch);
+    void endRound(std::map<uint32_t, SnapshotRound>::iterator it);
+    // Função para imprimir os resultados coletados em uma rodada e realizar a detecção de deadlock
+    void printSnapshot(uint32_t epoch, const SnapshotRound& round);
+    // Junta os resumos recebidos dos filhos da raiz da árvore de agregação e realiza a detecção de deadlock
+    void printSummary(uint32_t epoch, const SnapshotRound& round);
+    // Procura ciclos no grafo de espera montado em "waitEdges" e imprime o resultado
+    void detectDeadlock();
+    // Desfaz o deadlock dos filósofos do ciclo, revogando o garfo de uma vítima escolhida pelo critério configurado
+    void resolveDeadlock(const int* begin, const int* end);
+    // Função chamada pelo grafo de espera quando um pedido ou uma passagem de garfo fecha um ciclo
+    void onLiveDeadlock(const std::vector<int>& cycle);
     
 };
 
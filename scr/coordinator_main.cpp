@@ -0,0 +1,31 @@
+#include "coordinator.h"
+#include "shm_transport.h"
+
+// Carrega a configuração, cria uma instância da classe Coordinator e a inicia.
+// Com "coordinator_shards" maior que 1, o índice do fragmento é passado como argumento (0 se omitido)
+int main(int argc, char* argv[]) {
+    Config config;
+    std::vector<std::string> positional;
+    if (!Config::load(argc, argv, config, positional) || positional.size() > 1) {
+        std::cerr << "Uso: " << argv[0] << " [fragmento] [--config=arquivo] [--chave=valor ...]\n";
+        return 1;
+    }
+    int shard = positional.empty() ? 0 : std::atoi(positional[0].c_str());
+    if (shard < 0 || shard >= config.coordinatorShards) {
+        std::cerr << "Fragmento inválido: " << positional[0] << " (esperado 0 a " << config.coordinatorShards - 1 << ")\n";
+        return 1;
+    }
+    setLogLevel(config.logLevel);
+    // O fragmento 0 usa a porta de métricas do coordenador; os demais, as portas seguintes às dos filósofos
+    int metricsPort = config.metricsPort > 0 && shard > 0 ? config.metricsPort + config.numPhilosophers + shard : config.metricsPort;
+    startMetricsExporter(shard > 0 ? "COORDENADOR " + std::to_string(shard) : "COORDENADOR", config.host, metricsPort);
+    // Uma conexão de entrada e uma de saída por filósofo
+    raiseFileDescriptorLimit(2 * config.numPhilosophers + 64);
+
+    // Com "transport=shm" as mensagens vão pela memória compartilhada; caso contrário, pelos laços de eventos TCP
+    std::unique_ptr<Transport> transport;
+    if (config.transport == TransportKind::SHM) transport = std::make_unique<ShmTransport>(config, config.coordinatorShardPort(shard));
+    Coordinator coordinator(config, shard, transport.get());
+    coordinator.start();
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,98 @@
+#include "cycle_detector.h"
+
+#include <algorithm>
+
+// Ordenação por contagem: conta as arestas de cada nó, calcula os inícios (soma de prefixos) e distribui os destinos
+void CsrGraph::build(int numNodes, const std::vector<std::pair<int, int>>& edges) {
+    this->numNodes = numNodes;
+    offsets.assign(numNodes + 1, 0);
+
+    size_t valid = 0;
+    for (const auto& [from, to] : edges) {
+        if (from < 0 || from >= numNodes || to < 0 || to >= numNodes) continue;
+        offsets[from + 1]++;
+        valid++;
+    }
+    for (int v = 0; v < numNodes; ++v) offsets[v + 1] += offsets[v];
+
+    targets.resize(valid);
+    cursor.assign(offsets.begin(), offsets.end() - 1);
+    for (const auto& [from, to] : edges) {
+        if (from < 0 || from >= numNodes || to < 0 || to >= numNodes) continue;
+        targets[cursor[from]++] = to;
+    }
+}
+
+// Tarjan iterativo: a pilha de chamadas guarda, para cada nó em visita, a próxima aresta a explorar.
+// Quando todas as arestas de um nó foram exploradas e lowlink == index, ele é a raiz de uma componente,
+// que é retirada da pilha de Tarjan. A componente contém ciclo se tiver mais de um nó ou uma aresta para si mesma.
+size_t CycleDetector::run(const CsrGraph& graph) {
+    const int n = graph.nodeCount();
+    index.assign(n, -1);
+    lowlink.assign(n, 0);
+    onStack.assign(n, 0);
+    sccStack.clear();
+    callStack.clear();
+    members.clear();
+    cycleOffsets.clear();
+    cycleOffsets.push_back(0);
+
+    int nextIndex = 0;
+    for (int root = 0; root < n; ++root) {
+        // Nós sem arestas de saída nunca fazem parte de um ciclo
+        if (index[root] != -1 || graph.edgesBegin(root) == graph.edgesEnd(root)) continue;
+
+        index[root] = lowlink[root] = nextIndex++;
+        sccStack.push_back(root);
+        onStack[root] = 1;
+        callStack.push_back({ root, graph.edgesBegin(root) });
+
+        while (!callStack.empty()) {
+            Frame& frame = callStack.back();
+            int v = frame.node;
+
+            if (frame.edge < graph.edgesEnd(v)) {
+                int w = graph.target(frame.edge++);
+                if (index[w] == -1) {
+                    index[w] = lowlink[w] = nextIndex++;
+                    sccStack.push_back(w);
+                    onStack[w] = 1;
+                    // "frame" pode ser invalidado pelo push_back, por isso não é usado depois daqui
+                    callStack.push_back({ w, graph.edgesBegin(w) });
+                } else if (onStack[w]) {
+                    lowlink[v] = std::min(lowlink[v], index[w]);
+                }
+                continue;
+            }
+
+            if (lowlink[v] == index[v]) {
+                size_t begin = members.size();
+                int w;
+                do {
+                    w = sccStack.back();
+                    sccStack.pop_back();
+                    onStack[w] = 0;
+                    members.push_back(w);
+                } while (w != v);
+
+                bool hasCycle = members.size() - begin > 1;
+                for (uint32_t e = graph.edgesBegin(v); !hasCycle && e < graph.edgesEnd(v); ++e) {
+                    hasCycle = graph.target(e) == v;
+                }
+                if (hasCycle) {
+                    std::reverse(members.begin() + begin, members.end());
+                    cycleOffsets.push_back(static_cast<uint32_t>(members.size()));
+                } else {
+                    members.resize(begin);
+                }
+            }
+
+            callStack.pop_back();
+            if (!callStack.empty()) {
+                int parent = callStack.back().node;
+                lowlink[parent] = std::min(lowlink[parent], lowlink[v]);
+            }
+        }
+    }
+    return cycleCount();
+}
@@ -0,0 +1,66 @@
+#ifndef CYCLE_DETECTOR_H
+#define CYCLE_DETECTOR_H
+
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+
+
+// Grafo dirigido em formato CSR (compressed sparse row): as arestas de saída do nó "v" são
+// targets[offsets[v]] até targets[offsets[v + 1] - 1]. Os vetores são reaproveitados entre construções.
+class CsrGraph {
+public:
+    // Reconstrói o grafo com "numNodes" nós (IDs de 0 a numNodes - 1) a partir da lista de arestas (origem, destino).
+    // Arestas com nós fora do intervalo são ignoradas
+    void build(int numNodes, const std::vector<std::pair<int, int>>& edges);
+
+    int nodeCount() const { return numNodes; }
+    size_t edgeCount() const { return targets.size(); }
+    // Primeira e última (exclusiva) posição das arestas de saída do nó em "targets"
+    uint32_t edgesBegin(int node) const { return offsets[node]; }
+    uint32_t edgesEnd(int node) const { return offsets[node + 1]; }
+    int target(uint32_t edge) const { return targets[edge]; }
+
+private:
+    int numNodes = 0;
+    std::vector<uint32_t> offsets;
+    std::vector<int> targets;
+    // Próxima posição livre de cada nó durante a construção
+    std::vector<uint32_t> cursor;
+};
+
+// Detector de deadlocks sobre um grafo de espera: encontra as componentes fortemente conexas (algoritmo de Tarjan,
+// em versão iterativa para não estourar a pilha em grafos grandes) e devolve todas as que contêm ciclos.
+// Cada componente devolvida é um conjunto de filósofos em deadlock, com todos os seus membros.
+// As áreas de trabalho e os resultados são reaproveitados entre execuções, sem alocações depois da primeira.
+class CycleDetector {
+public:
+    // Procura as componentes com ciclo no grafo. Retorna quantas foram encontradas
+    size_t run(const CsrGraph& graph);
+    // Número de componentes com ciclo encontradas na última execução
+    size_t cycleCount() const { return cycleOffsets.empty() ? 0 : cycleOffsets.size() - 1; }
+    // Membros da componente "i" (início e fim do intervalo)
+    std::pair<const int*, const int*> cycle(size_t i) const {
+        return { members.data() + cycleOffsets[i], members.data() + cycleOffsets[i + 1] };
+    }
+
+private:
+    // Quadro da busca em profundidade iterativa: o nó e a próxima aresta a visitar
+    struct Frame {
+        int node;
+        uint32_t edge;
+    };
+
+    std::vector<int> index;
+    std::vector<int> lowlink;
+    std::vector<uint8_t> onStack;
+    std::vector<int> sccStack;
+    std::vector<Frame> callStack;
+
+    // Membros das componentes com ciclo, em sequência, e o início de cada componente
+    std::vector<int> members;
+    std::vector<uint32_t> cycleOffsets;
+};
+
+#endif
@@ -0,0 +1,67 @@
+#include "executor.h"
+
+// Executor ao qual a thread atual pertence e o índice da sua fila (nulo para threads de fora de qualquer executor)
+static thread_local const Executor* currentExecutor = nullptr;
+static thread_local size_t currentIndex = 0;
+
+Executor::Executor(const std::string& owner, size_t threads) : owner(owner) {
+    if (threads == 0) threads = 1;
+    for (size_t i = 0; i < threads; ++i) queues.push_back(std::make_unique<Queue>());
+    for (size_t i = 0; i < threads; ++i) workers.emplace_back(&Executor::workerLoop, this, i);
+}
+
+// As threads deixam de retirar tarefas assim que "stopping" é marcado; as que ficaram nas filas são destruídas sem executar
+Executor::~Executor() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMtx);
+        stopping = true;
+    }
+    wakeup.notify_all();
+    for (std::thread& worker : workers) worker.join();
+    for (std::unique_ptr<Queue>& queue : queues) queue->tasks.clear();
+}
+
+// Uma tarefa agendada por uma thread do executor (por exemplo, a continuação de outra tarefa) fica na fila dela,
+// onde é executada em seguida sem passar por outra thread; as demais vão para as filas em rodízio.
+// O contador de pendentes é incrementado antes de a tarefa ficar visível, e o "notify" só é feito com o mutex de espera,
+// para que uma thread prestes a dormir não perca a tarefa
+void Executor::submit(Task task) {
+    size_t index = currentExecutor == this ? currentIndex : nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+    pending.fetch_add(1, std::memory_order_seq_cst);
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mtx);
+        queues[index]->tasks.push_back(std::move(task));
+    }
+    std::lock_guard<std::mutex> lock(sleepMtx);
+    wakeup.notify_one();
+}
+
+// Percorre as outras filas a partir da seguinte, para que as threads não roubem todas da mesma.
+// Tanto a dona quanto as outras threads retiram do início, então a tarefa roubada é a mais antiga da fila
+bool Executor::take(size_t index, Task& task) {
+    for (size_t offset = 0; offset < queues.size(); ++offset) {
+        Queue& queue = *queues[(index + offset) % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mtx);
+        if (queue.tasks.empty()) continue;
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        pending.fetch_sub(1, std::memory_order_seq_cst);
+        return true;
+    }
+    return false;
+}
+
+void Executor::workerLoop(size_t index) {
+    currentExecutor = this;
+    currentIndex = index;
+    Task task;
+    while (!stopping) {
+        if (take(index, task)) {
+            task();
+            task = nullptr;
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMtx);
+        wakeup.wait(lock, [this] { return stopping || pending.load(std::memory_order_seq_cst) > 0; });
+    }
+}
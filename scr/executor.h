@@ -0,0 +1,57 @@
+#ifndef EXECUTOR_H
+#define EXECUTOR_H
+
+#include <string>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <thread>
+#include <atomic>
+#include <cstddef>
+
+
+// Conjunto pequeno de threads com roubo de tarefas ("work stealing").
+// Cada thread tem a sua própria fila: as tarefas criadas por uma thread do executor vão para a fila dela,
+// e as criadas por outras threads são distribuídas entre as filas em rodízio. Uma thread sem tarefas rouba
+// a tarefa mais antiga da fila de outra, de forma que uma tarefa lenta (por exemplo, um envio para um destino que
+// não responde) ocupa apenas uma thread enquanto as demais continuam esvaziando as outras filas.
+class Executor {
+public:
+    using Task = std::function<void()>;
+
+    // Cria "threads" threads (pelo menos uma). "owner" identifica o dono nas mensagens impressas
+    Executor(const std::string& owner, size_t threads);
+    // Descarta as tarefas ainda não iniciadas e espera as threads terminarem
+    ~Executor();
+
+    // Agenda a tarefa para execução em alguma das threads. Pode ser chamada de qualquer thread
+    void submit(Task task);
+
+private:
+    // Fila de uma thread. A dona e as outras threads retiram do início, na ordem de agendamento
+    struct Queue {
+        std::mutex mtx;
+        std::deque<Task> tasks;
+    };
+
+    std::string owner;
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+    // Próxima fila para tarefas agendadas de fora do executor
+    std::atomic<size_t> nextQueue{0};
+    // Tarefas agendadas e ainda não retiradas de nenhuma fila; as threads dormem quando chega a zero
+    std::atomic<size_t> pending{0};
+    std::mutex sleepMtx;
+    std::condition_variable wakeup;
+    std::atomic<bool> stopping{false};
+
+    // Laço de cada thread: executa as tarefas da própria fila, rouba das outras ou dorme
+    void workerLoop(size_t index);
+    // Retira a próxima tarefa da própria fila ou, se estiver vazia, de outra fila
+    bool take(size_t index, Task& task);
+};
+
+#endif
@@ -0,0 +1,250 @@
+#include "fork_table.h"
+
+#include <algorithm>
+
+ForkTable::ForkTable(int numForks)
+    : count(numForks),
+      owners(new std::atomic<int32_t>[numForks]),
+      queued(new std::atomic<int32_t>[numForks]),
+      queues(new WaitQueue[numForks]) {
+    for (int i = 0; i < numForks; ++i) {
+        owners[i].store(FREE, std::memory_order_relaxed);
+        queued[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+// Caminho rápido: sem ninguém na fila, troca FREE pelo ID do filósofo em uma única operação atômica.
+// Se duas threads pedirem o mesmo garfo ao mesmo tempo, apenas uma delas consegue a troca.
+// Caminho lento: o filósofo entra na fila e, se o garfo tiver sido liberado nesse meio tempo, o primeiro da fila o recebe.
+// Como o tamanho da fila é incrementado antes da nova tentativa, uma liberação concorrente sempre vê a fila ou deixa o
+// garfo livre para essa tentativa, e nenhum pedido fica esquecido na fila.
+ForkTable::Grant ForkTable::acquire(int forkId, int philosopherId) {
+    Grant grant;
+    if (!valid(forkId)) return grant;
+
+    if (queued[forkId].load() == 0) {
+        int32_t expected = FREE;
+        if (owners[forkId].compare_exchange_strong(expected, philosopherId)) {
+            grant.philosopherId = philosopherId;
+            // Alguém entrou na fila entre a verificação e a troca: o grafo precisa saber quem é o dono
+            if (graph && queued[forkId].load() > 0) {
+                std::lock_guard<std::mutex> lock(queues[forkId].mtx);
+                graph->handOff(forkId, philosopherId);
+            }
+            return grant;
+        }
+        // Pedido repetido de quem já possui o garfo: confirma a posse
+        if (expected == philosopherId) {
+            grant.philosopherId = philosopherId;
+            return grant;
+        }
+    }
+
+    WaitQueue& queue = queues[forkId];
+    std::lock_guard<std::mutex> lock(queue.mtx);
+    bool alreadyQueued = std::any_of(queue.waiting.begin(), queue.waiting.end(),
+                                     [philosopherId](const Waiter& entry) { return entry.philosopherId == philosopherId; });
+    if (!alreadyQueued && owners[forkId].load() != philosopherId) {
+        queue.waiting.push_back({ philosopherId, Clock::now() });
+        queued[forkId].fetch_add(1);
+        if (graph) graph->addWait(philosopherId, forkId, owners[forkId].load());
+    }
+    return grantNextLocked(forkId);
+}
+
+// Só libera se o garfo ainda pertence ao filósofo, ignorando liberações duplicadas ou de quem não é o dono.
+// Havendo fila, o garfo é entregue ao primeiro filósofo dela, na ordem de chegada dos pedidos.
+bool ForkTable::release(int forkId, int philosopherId, Grant& next) {
+    next = Grant();
+    if (!valid(forkId)) return false;
+
+    int32_t expected = philosopherId;
+    if (!owners[forkId].compare_exchange_strong(expected, FREE)) return false;
+
+    if (queued[forkId].load() > 0) {
+        std::lock_guard<std::mutex> lock(queues[forkId].mtx);
+        next = grantNextLocked(forkId);
+    }
+    return true;
+}
+
+ForkTable::Grant ForkTable::grantNextLocked(int forkId) {
+    Grant grant;
+    WaitQueue& queue = queues[forkId];
+    if (queue.waiting.empty()) return grant;
+
+    Waiter head = queue.waiting.front();
+    int32_t expected = FREE;
+    if (!owners[forkId].compare_exchange_strong(expected, head.philosopherId)) return grant;
+
+    queue.waiting.pop_front();
+    queued[forkId].fetch_sub(1);
+    if (graph) graph->handOff(forkId, head.philosopherId);
+
+    grant.philosopherId = head.philosopherId;
+    recordWait(grant, head.since);
+    return grant;
+}
+
+// Pedidos de pares não usam o caminho rápido: conceder os dois garfos com duas trocas separadas exigiria desfazer
+// a primeira quando a segunda falha, e um pedido que entrou na fila nesse meio tempo poderia ficar esquecido.
+// Os dois locks são adquiridos juntos (sem risco de deadlock entre pedidos com garfos em comum), então o pedido
+// entra nas duas filas de forma atômica, e todas as filas veem os pedidos de pares na mesma ordem.
+ForkTable::Grant ForkTable::acquirePair(int firstFork, int secondFork, int philosopherId) {
+    Grant grant;
+    if (!valid(firstFork) || !valid(secondFork) || firstFork == secondFork) return grant;
+
+    WaitQueue& first = queues[firstFork];
+    WaitQueue& second = queues[secondFork];
+    std::scoped_lock lock(first.mtx, second.mtx);
+    // Pedido repetido de quem já possui os garfos: confirma a posse
+    if (owners[firstFork].load() == philosopherId && owners[secondFork].load() == philosopherId) {
+        grant.philosopherId = philosopherId;
+        return grant;
+    }
+    // Os dois livres e sem fila: concedidos imediatamente
+    if (first.waiting.empty() && second.waiting.empty() &&
+        owners[firstFork].load() == FREE && owners[secondFork].load() == FREE) {
+        owners[firstFork].store(philosopherId);
+        owners[secondFork].store(philosopherId);
+        grant.philosopherId = philosopherId;
+        return grant;
+    }
+    bool alreadyQueued = std::any_of(first.waiting.begin(), first.waiting.end(),
+                                     [philosopherId](const Waiter& entry) { return entry.philosopherId == philosopherId; });
+    if (!alreadyQueued) {
+        Clock::time_point now = Clock::now();
+        first.waiting.push_back({ philosopherId, now, secondFork });
+        second.waiting.push_back({ philosopherId, now, firstFork });
+        queued[firstFork].fetch_add(1);
+        queued[secondFork].fetch_add(1);
+        if (graph) {
+            graph->addWait(philosopherId, firstFork, owners[firstFork].load());
+            graph->addWait(philosopherId, secondFork, owners[secondFork].load());
+        }
+    }
+    return grantPairLocked(firstFork, secondFork);
+}
+
+// Cada garfo liberado pode completar o par do primeiro da sua fila, que é o vizinho do outro lado do garfo
+bool ForkTable::releasePair(int firstFork, int secondFork, int philosopherId, std::vector<Grant>& next) {
+    next.clear();
+    if (!valid(firstFork) || !valid(secondFork) || firstFork == secondFork) return false;
+    {
+        std::scoped_lock lock(queues[firstFork].mtx, queues[secondFork].mtx);
+        if (owners[firstFork].load() != philosopherId || owners[secondFork].load() != philosopherId) return false;
+        owners[firstFork].store(FREE);
+        owners[secondFork].store(FREE);
+        if (graph) {
+            graph->handOff(firstFork, FREE);
+            graph->handOff(secondFork, FREE);
+        }
+    }
+    for (int forkId : { firstFork, secondFork }) {
+        Grant grant = grantPairHead(forkId);
+        if (grant.granted()) next.push_back(grant);
+    }
+    return true;
+}
+
+// O outro garfo do primeiro da fila só é conhecido depois de olhar a fila, e os dois locks precisam ser adquiridos
+// juntos; se o início da fila mudar nesse meio tempo, a tentativa é refeita com o novo primeiro
+ForkTable::Grant ForkTable::grantPairHead(int forkId) {
+    while (true) {
+        int32_t otherFork;
+        {
+            std::lock_guard<std::mutex> lock(queues[forkId].mtx);
+            if (queues[forkId].waiting.empty()) return Grant();
+            otherFork = queues[forkId].waiting.front().pairedFork;
+        }
+        if (!valid(otherFork)) return Grant();
+
+        std::scoped_lock lock(queues[forkId].mtx, queues[otherFork].mtx);
+        if (queues[forkId].waiting.empty()) return Grant();
+        if (queues[forkId].waiting.front().pairedFork != otherFork) continue;
+        return grantPairLocked(forkId, otherFork);
+    }
+}
+
+ForkTable::Grant ForkTable::grantPairLocked(int firstFork, int secondFork) {
+    Grant grant;
+    WaitQueue& first = queues[firstFork];
+    WaitQueue& second = queues[secondFork];
+    if (first.waiting.empty() || second.waiting.empty()) return grant;
+
+    Waiter head = first.waiting.front();
+    if (head.pairedFork != secondFork || second.waiting.front().philosopherId != head.philosopherId) return grant;
+    if (owners[firstFork].load() != FREE || owners[secondFork].load() != FREE) return grant;
+
+    owners[firstFork].store(head.philosopherId);
+    owners[secondFork].store(head.philosopherId);
+    first.waiting.pop_front();
+    second.waiting.pop_front();
+    queued[firstFork].fetch_sub(1);
+    queued[secondFork].fetch_sub(1);
+    if (graph) {
+        graph->handOff(firstFork, head.philosopherId);
+        graph->handOff(secondFork, head.philosopherId);
+    }
+
+    grant.philosopherId = head.philosopherId;
+    recordWait(grant, head.since);
+    return grant;
+}
+
+void ForkTable::recordWait(Grant& grant, Clock::time_point since) {
+    grant.waitNs = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - since).count();
+    queuedGrants.fetch_add(1, std::memory_order_relaxed);
+    totalWaitNs.fetch_add(grant.waitNs, std::memory_order_relaxed);
+    uint64_t currentMax = maxWaitNs.load(std::memory_order_relaxed);
+    while (grant.waitNs > currentMax && !maxWaitNs.compare_exchange_weak(currentMax, grant.waitNs, std::memory_order_relaxed)) {}
+}
+
+// As duas verificações e a revogação são feitas com os locks das duas filas: a concessão de "waitedFork" à vítima
+// (que a deixaria comer) também é feita com o lock da fila, então a vítima nunca perde um garfo enquanto come
+bool ForkTable::preempt(int forkId, int victimId, int waitedFork, Grant& next) {
+    next = Grant();
+    if (!valid(forkId) || !valid(waitedFork) || forkId == waitedFork) return false;
+
+    std::scoped_lock lock(queues[forkId].mtx, queues[waitedFork].mtx);
+    const std::deque<Waiter>& waiting = queues[waitedFork].waiting;
+    bool victimWaiting = std::any_of(waiting.begin(), waiting.end(),
+                                     [victimId](const Waiter& entry) { return entry.philosopherId == victimId; });
+    if (!victimWaiting) return false;
+    int32_t expected = victimId;
+    if (!owners[forkId].compare_exchange_strong(expected, FREE)) return false;
+
+    if (graph) graph->handOff(forkId, FREE);
+    next = grantNextLocked(forkId);
+    return true;
+}
+
+bool ForkTable::waitingSince(int forkId, int philosopherId, Clock::time_point& since) {
+    if (!valid(forkId)) return false;
+    std::lock_guard<std::mutex> lock(queues[forkId].mtx);
+    for (const Waiter& entry : queues[forkId].waiting) {
+        if (entry.philosopherId == philosopherId) {
+            since = entry.since;
+            return true;
+        }
+    }
+    return false;
+}
+
+int32_t ForkTable::owner(int forkId) const {
+    if (!valid(forkId)) return FREE;
+    return owners[forkId].load(std::memory_order_acquire);
+}
+
+// Imprime quantos garfos foram concedidos a partir das filas, as esperas média e máxima (em milissegundos)
+// e quantos filósofos estão esperando neste momento
+void ForkTable::printStats(std::ostream& out) const {
+    uint64_t grants = queuedGrants.load(std::memory_order_relaxed);
+    uint64_t waitingNow = 0;
+    for (int i = 0; i < count; ++i) waitingNow += queued[i].load(std::memory_order_relaxed);
+    double avgMs = grants ? (totalWaitNs.load(std::memory_order_relaxed) / 1e6) / grants : 0.0;
+    out << "[COORDENADOR] Filas de garfos: concessões após espera=" << grants
+        << ", espera média=" << avgMs << "ms"
+        << ", máxima=" << maxWaitNs.load(std::memory_order_relaxed) / 1e6 << "ms"
+        << ", esperando agora=" << waitingNow << "\n" << std::flush;
+}
@@ -0,0 +1,108 @@
+#ifndef FORK_TABLE_H
+#define FORK_TABLE_H
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+#include <cstdint>
+
+#include "wait_for_graph.h"
+
+
+// Tabela de posse dos garfos, indexada diretamente pelo ID do garfo.
+// Cada garfo é uma palavra atômica com o ID do filósofo que o possui (ou FREE), armazenadas de forma contígua.
+// Concessões e liberações usam compare-and-swap, sem nenhum lock global, e podem ser feitas de qualquer thread.
+// Pedidos por um garfo ocupado entram em uma fila FIFO do próprio garfo, e o garfo é passado diretamente ao
+// próximo da fila quando for liberado. Só o caminho com disputa usa o lock (individual) da fila do garfo.
+class ForkTable {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Valor de um garfo que não pertence a nenhum filósofo
+    static const int32_t FREE = -1;
+
+    // Resultado de uma operação que pode conceder um garfo
+    struct Grant {
+        // Filósofo que recebeu o garfo (FREE se nenhum recebeu)
+        int32_t philosopherId = FREE;
+        // Tempo que o filósofo esperou na fila (0 se o garfo foi concedido imediatamente)
+        uint64_t waitNs = 0;
+
+        bool granted() const { return philosopherId != FREE; }
+    };
+
+    // Cria a tabela com "numForks" garfos, todos disponíveis
+    explicit ForkTable(int numForks);
+
+    // Associa o grafo de espera que deve ser atualizado a cada mudança nas filas (opcional)
+    void attachGraph(WaitForGraph* graph) { this->graph = graph; }
+    // Indica se o ID corresponde a um garfo da tabela
+    bool valid(int forkId) const { return forkId >= 0 && forkId < count; }
+    // Número de garfos
+    int size() const { return count; }
+    // Pede o garfo para o filósofo. Se ele estiver livre e sem fila, é concedido imediatamente;
+    // caso contrário o filósofo entra na fila do garfo. Retorna a concessão resultante, se houver.
+    Grant acquire(int forkId, int philosopherId);
+    // Libera o garfo, desde que ele pertença ao filósofo (retorna falso caso contrário).
+    // Se houver filósofos na fila, o garfo é passado ao primeiro deles, informado em "next".
+    bool release(int forkId, int philosopherId, Grant& next);
+    // Modo "acquire_mode=pair": pede os dois garfos de uma vez, concedidos juntos ou nenhum. Se algum deles estiver
+    // ocupado, ou já houver alguém na fila de algum deles, o pedido entra nas filas dos dois ao mesmo tempo.
+    // O filósofo nunca segura um garfo enquanto espera pelo outro, e nenhuma espera circular pode se formar.
+    Grant acquirePair(int firstFork, int secondFork, int philosopherId);
+    // Libera os dois garfos, desde que ambos pertençam ao filósofo (retorna falso caso contrário).
+    // Os pedidos de pares que puderem ser atendidos com os garfos liberados são concedidos e informados em "next".
+    bool releasePair(int firstFork, int secondFork, int philosopherId, std::vector<Grant>& next);
+    // Resolução de deadlocks: revoga o garfo do filósofo, desde que ele ainda o possua e ainda esteja na fila de
+    // "waitedFork" (retorna falso caso contrário). O garfo é passado ao primeiro da sua fila, informado em "next"
+    bool preempt(int forkId, int victimId, int waitedFork, Grant& next);
+    // Informa em "since" desde quando o filósofo está na fila do garfo. Retorna falso se ele não estiver na fila
+    bool waitingSince(int forkId, int philosopherId, Clock::time_point& since);
+    // Retorna o dono atual do garfo (ou FREE)
+    int32_t owner(int forkId) const;
+    // Imprime as estatísticas das filas de espera
+    void printStats(std::ostream& out) const;
+
+private:
+    // Filósofo esperando, com o instante em que entrou na fila
+    struct Waiter {
+        int32_t philosopherId;
+        Clock::time_point since;
+        // Outro garfo pedido junto, em um pedido de par (FREE em pedidos individuais)
+        int32_t pairedFork = FREE;
+    };
+
+    // Fila de espera de um garfo
+    struct WaitQueue {
+        std::mutex mtx;
+        std::deque<Waiter> waiting;
+    };
+
+    int count;
+    std::unique_ptr<std::atomic<int32_t>[]> owners;
+    // Tamanho de cada fila, lido sem lock para decidir se o caminho rápido pode ser usado
+    std::unique_ptr<std::atomic<int32_t>[]> queued;
+    std::unique_ptr<WaitQueue[]> queues;
+    WaitForGraph* graph = nullptr;
+
+    // Estatísticas das concessões feitas a partir das filas
+    std::atomic<uint64_t> queuedGrants{0};
+    std::atomic<uint64_t> totalWaitNs{0};
+    std::atomic<uint64_t> maxWaitNs{0};
+
+    // Com o lock da fila adquirido, concede o garfo ao primeiro da fila se ele estiver livre
+    Grant grantNextLocked(int forkId);
+    // Com os locks das duas filas adquiridos, concede o par ao filósofo que estiver no início das duas filas,
+    // se os dois garfos estiverem livres
+    Grant grantPairLocked(int firstFork, int secondFork);
+    // Tenta completar o par do primeiro da fila do garfo, que também depende da fila do seu outro garfo
+    Grant grantPairHead(int forkId);
+    // Registra nas estatísticas a espera de uma concessão feita a partir da fila
+    void recordWait(Grant& grant, Clock::time_point since);
+};
+
+#endif
@@ -0,0 +1,79 @@
+#include "frame.h"
+
+#include <cstring>
+#include <unistd.h>
+
+// Grava o tamanho em ordem de bytes de rede (big-endian)
+void encodeFrameHeader(uint32_t size, char header[FRAME_HEADER_SIZE]) {
+    header[0] = static_cast<char>((size >> 24) & 0xFF);
+    header[1] = static_cast<char>((size >> 16) & 0xFF);
+    header[2] = static_cast<char>((size >> 8) & 0xFF);
+    header[3] = static_cast<char>(size & 0xFF);
+}
+
+void appendFrame(std::string& out, std::string_view payload) {
+    char header[FRAME_HEADER_SIZE];
+    encodeFrameHeader(static_cast<uint32_t>(payload.size()), header);
+    out.append(header, FRAME_HEADER_SIZE);
+    out.append(payload.data(), payload.size());
+}
+
+// Lê o tamanho gravado por "encodeFrameHeader"
+static uint32_t decodeFrameHeader(const char* header) {
+    const unsigned char* h = reinterpret_cast<const unsigned char*>(header);
+    return (uint32_t(h[0]) << 24) | (uint32_t(h[1]) << 16) | (uint32_t(h[2]) << 8) | uint32_t(h[3]);
+}
+
+FrameReader::FrameReader(size_t initialCapacity) : buffer(initialCapacity) {}
+
+// Se os dados pendentes cabem no buffer atual, eles são apenas movidos para o início.
+// Caso contrário, a capacidade é dobrada até caber. O buffer nunca diminui, sendo reaproveitado pela conexão toda.
+void FrameReader::reserveTail(size_t minFree) {
+    if (buffer.size() - end >= minFree) return;
+
+    size_t pending = end - begin;
+    if (begin > 0) {
+        std::memmove(buffer.data(), buffer.data() + begin, pending);
+        begin = 0;
+        end = pending;
+    }
+    size_t capacity = buffer.size();
+    while (capacity - end < minFree) capacity *= 2;
+    if (capacity != buffer.size()) buffer.resize(capacity);
+}
+
+// Quando o cabeçalho da próxima mensagem já chegou, reserva espaço para a mensagem inteira,
+// assim uma mensagem grande é lida com poucas chamadas de "read".
+ssize_t FrameReader::fill(int fd) {
+    if (begin == end) {
+        begin = 0;
+        end = 0;
+    }
+
+    size_t wanted = 1024;
+    if (end - begin >= FRAME_HEADER_SIZE) {
+        uint32_t size = decodeFrameHeader(buffer.data() + begin);
+        size_t total = FRAME_HEADER_SIZE + size;
+        if (size <= MAX_FRAME_SIZE && total > end - begin) wanted = total - (end - begin);
+    }
+    reserveTail(wanted);
+
+    ssize_t valread = read(fd, buffer.data() + end, buffer.size() - end);
+    if (valread > 0) end += valread;
+    return valread;
+}
+
+bool FrameReader::next(std::string_view& payload) {
+    if (invalid || end - begin < FRAME_HEADER_SIZE) return false;
+
+    uint32_t size = decodeFrameHeader(buffer.data() + begin);
+    if (size > MAX_FRAME_SIZE) {
+        invalid = true;
+        return false;
+    }
+    if (end - begin < FRAME_HEADER_SIZE + size) return false;
+
+    payload = std::string_view(buffer.data() + begin + FRAME_HEADER_SIZE, size);
+    begin += FRAME_HEADER_SIZE + size;
+    return true;
+}
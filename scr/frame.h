@@ -0,0 +1,54 @@
+#ifndef FRAME_H
+#define FRAME_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <sys/types.h>
+
+
+// Protocolo de enquadramento das mensagens nos fluxos TCP persistentes.
+// Cada mensagem é precedida por um cabeçalho de 4 bytes com o tamanho do conteúdo (big-endian),
+// o que permite transportar conteúdos de qualquer tamanho e várias mensagens seguidas na mesma conexão.
+
+// Tamanho do cabeçalho de cada mensagem
+const size_t FRAME_HEADER_SIZE = 4;
+// Maior conteúdo aceito em uma única mensagem. Protege o leitor de cabeçalhos corrompidos
+const uint32_t MAX_FRAME_SIZE = 64 * 1024 * 1024;
+
+// Escreve o cabeçalho de uma mensagem com o tamanho especificado
+void encodeFrameHeader(uint32_t size, char header[FRAME_HEADER_SIZE]);
+// Acrescenta ao final de "out" a mensagem enquadrada (cabeçalho + conteúdo)
+void appendFrame(std::string& out, std::string_view payload);
+
+// Leitor incremental de mensagens enquadradas de uma conexão.
+// Mantém um buffer de recepção reutilizado entre leituras e entrega as mensagens como "string_view"
+// apontando diretamente para esse buffer, sem cópias. Uma mensagem entregue continua válida apenas
+// até a próxima chamada de "fill".
+class FrameReader {
+public:
+    explicit FrameReader(size_t initialCapacity = 4096);
+
+    // Lê do socket o que estiver disponível para o buffer.
+    // Retorna o número de bytes lidos, 0 se a conexão foi fechada ou -1 em caso de erro (errno preservado)
+    ssize_t fill(int fd);
+    // Extrai a próxima mensagem completa do buffer. Retorna falso se ainda não há mensagem completa
+    bool next(std::string_view& payload);
+    // Indica se foi recebido um cabeçalho inválido (tamanho acima de MAX_FRAME_SIZE)
+    bool corrupted() const { return invalid; }
+
+private:
+    std::vector<char> buffer;
+    // Início dos dados ainda não consumidos
+    size_t begin = 0;
+    // Fim dos dados recebidos
+    size_t end = 0;
+    bool invalid = false;
+
+    // Garante espaço livre no final do buffer, movendo os dados pendentes para o início ou aumentando sua capacidade
+    void reserveTail(size_t minFree);
+};
+
+#endif
@@ -0,0 +1,243 @@
+#include "log.h"
+
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+std::atomic<uint8_t> runtimeLogLevel{ static_cast<uint8_t>(LogLevel::INFO) };
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Número de entradas do buffer circular (potência de 2)
+const size_t LOG_CAPACITY = 4096;
+// Tempo máximo que a thread de escrita dorme sem ser acordada
+const long LOG_IDLE_WAIT_NS = 100000000;
+
+// Entrada do buffer circular. "sequence" indica se a entrada está livre para o produtor ou pronta para o consumidor
+struct LogEntry {
+    std::atomic<size_t> sequence;
+    Clock::time_point time;
+    LogLevel level;
+    uint16_t size;
+    char text[LOG_LINE_SIZE];
+};
+
+// Fila circular limitada com vários produtores e consumidores, sem locks (algoritmo de Dmitry Vyukov).
+// Cada produtor reserva uma posição com um CAS em "tail" e publica a entrada atualizando o seu "sequence"
+class LogRing {
+public:
+    LogRing() {
+        for (size_t i = 0; i < LOG_CAPACITY; ++i) entries[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    // Retorna falso se a fila estiver cheia
+    bool push(LogLevel level, const char* text, size_t size) {
+        size_t pos = tail.load(std::memory_order_relaxed);
+        LogEntry* entry;
+        while (true) {
+            entry = &entries[pos & (LOG_CAPACITY - 1)];
+            size_t seq = entry->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+        entry->time = Clock::now();
+        entry->level = level;
+        entry->size = static_cast<uint16_t>(size);
+        std::memcpy(entry->text, text, size);
+        entry->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Verifica se a próxima entrada ainda não foi publicada
+    bool empty() const {
+        size_t pos = head.load(std::memory_order_relaxed);
+        return entries[pos & (LOG_CAPACITY - 1)].sequence.load(std::memory_order_acquire) != pos + 1;
+    }
+
+    // Retira a próxima entrada pronta e a passa para "consume". Retorna falso se a fila estiver vazia
+    template <typename Consume>
+    bool pop(Consume consume) {
+        size_t pos = head.load(std::memory_order_relaxed);
+        LogEntry* entry;
+        while (true) {
+            entry = &entries[pos & (LOG_CAPACITY - 1)];
+            size_t seq = entry->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = head.load(std::memory_order_relaxed);
+            }
+        }
+        consume(*entry);
+        entry->sequence.store(pos + LOG_CAPACITY, std::memory_order_release);
+        return true;
+    }
+
+private:
+    // Produtores e consumidores em linhas de cache separadas
+    alignas(64) std::atomic<size_t> tail{ 0 };
+    alignas(64) std::atomic<size_t> head{ 0 };
+    LogEntry entries[LOG_CAPACITY];
+};
+
+// Buffer circular, thread de escrita e contadores do processo
+class Logger {
+public:
+    static Logger& instance() {
+        static Logger* logger = new Logger();
+        return *logger;
+    }
+
+    // Depois de publicar a linha, só toca o "doorbell" e faz a chamada ao kernel se a thread de escrita estiver dormindo
+    void push(LogLevel level, const char* text, size_t size) {
+        if (!ring->push(level, text, size)) dropped.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleeping.load(std::memory_order_relaxed)) {
+            doorbell.fetch_add(1, std::memory_order_relaxed);
+            syscall(SYS_futex, reinterpret_cast<uint32_t*>(&doorbell), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+        }
+    }
+
+    // Escreve todas as entradas pendentes. Protegido por um mutex apenas entre os consumidores (thread de escrita e logFlush)
+    bool drain() {
+        std::lock_guard<std::mutex> lock(writeMtx);
+        bool wrote = false;
+        uint64_t lost = dropped.exchange(0, std::memory_order_relaxed);
+        if (lost > 0) {
+            std::fprintf(stdout, "%12.6f WARN  %llu mensagens de log descartadas (buffer cheio)\n",
+                         std::chrono::duration<double>(Clock::now() - start).count(), static_cast<unsigned long long>(lost));
+            wrote = true;
+        }
+        while (ring->pop([this](const LogEntry& entry) {
+            double seconds = std::chrono::duration<double>(entry.time - start).count();
+            std::fprintf(stdout, "%12.6f %-5s %.*s\n", seconds, logLevelName(entry.level), static_cast<int>(entry.size), entry.text);
+        })) {
+            wrote = true;
+        }
+        if (wrote) std::fflush(stdout);
+        return wrote;
+    }
+
+private:
+    std::unique_ptr<LogRing> ring = std::make_unique<LogRing>();
+    std::atomic<uint64_t> dropped{ 0 };
+    std::mutex writeMtx;
+    Clock::time_point start = Clock::now();
+    // Palavra do futex em que a thread de escrita dorme, e a indicação de que ela pode estar dormindo
+    std::atomic<uint32_t> doorbell{ 0 };
+    std::atomic<uint32_t> sleeping{ 0 };
+
+    // Sem nada a escrever, a thread de escrita marca "sleeping" e dorme no futex, a menos que uma linha tenha sido publicada
+    // depois disso (o produtor que a publicou vê "sleeping" e toca o "doorbell"). As linhas pendentes ao final do processo
+    // são escritas por "logFlush"
+    Logger() {
+        std::thread([this] {
+            while (true) {
+                if (drain()) continue;
+                uint32_t bell = doorbell.load(std::memory_order_relaxed);
+                sleeping.store(1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (ring->empty() && dropped.load(std::memory_order_relaxed) == 0) {
+                    timespec timeout{ 0, LOG_IDLE_WAIT_NS };
+                    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&doorbell), FUTEX_WAIT_PRIVATE, bell, &timeout, nullptr, 0);
+                }
+                sleeping.store(0, std::memory_order_relaxed);
+            }
+        }).detach();
+        std::atexit(logFlush);
+    }
+};
+
+} // namespace
+
+const char* logLevelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::TRACE: return "TRACE";
+        case LogLevel::DEBUG: return "DEBUG";
+        case LogLevel::INFO: return "INFO";
+        case LogLevel::WARN: return "WARN";
+        case LogLevel::ERROR: return "ERROR";
+        case LogLevel::OFF: return "OFF";
+    }
+    return "?";
+}
+
+bool parseLogLevel(const std::string& name, LogLevel& level) {
+    static const std::pair<const char*, LogLevel> names[] = {
+        { "trace", LogLevel::TRACE }, { "debug", LogLevel::DEBUG }, { "info", LogLevel::INFO },
+        { "warn", LogLevel::WARN }, { "error", LogLevel::ERROR }, { "off", LogLevel::OFF },
+    };
+    for (const auto& [candidate, value] : names) {
+        if (name == candidate) {
+            level = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+void logText(LogLevel level, std::string_view text) {
+    if (!logEnabled(level)) return;
+    while (!text.empty()) {
+        size_t end = text.find('\n');
+        std::string_view line = text.substr(0, end);
+        if (!line.empty()) LogLine(level) << line;
+        if (end == std::string_view::npos) break;
+        text.remove_prefix(end + 1);
+    }
+}
+
+void logFlush() {
+    Logger::instance().drain();
+}
+
+// Uma linha truncada termina com LOG_TRUNCATED no lugar dos seus últimos caracteres
+LogLine::~LogLine() {
+    if (truncated) std::memcpy(text + LOG_LINE_SIZE - LOG_TRUNCATED.size(), LOG_TRUNCATED.data(), LOG_TRUNCATED.size());
+    Logger::instance().push(level, text, size);
+}
+
+void LogLine::append(const char* data, size_t length) {
+    size_t n = length < LOG_LINE_SIZE - size ? length : LOG_LINE_SIZE - size;
+    std::memcpy(text + size, data, n);
+    size += n;
+    if (n < length) truncated = true;
+}
+
+void LogLine::appendSigned(long long value) {
+    char buffer[24];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    append(buffer, result.ptr - buffer);
+}
+
+void LogLine::appendUnsigned(unsigned long long value) {
+    char buffer[24];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    append(buffer, result.ptr - buffer);
+}
+
+LogLine& LogLine::operator<<(double value) {
+    char buffer[32];
+    int n = std::snprintf(buffer, sizeof(buffer), "%g", value);
+    if (n > 0) append(buffer, static_cast<size_t>(n) < sizeof(buffer) ? n : sizeof(buffer) - 1);
+    return *this;
+}
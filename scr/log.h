@@ -0,0 +1,111 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <string>
+#include <string_view>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+
+
+// Registro assíncrono de mensagens.
+// As threads formatam cada linha em um buffer na própria pilha e a copiam para um buffer circular sem locks;
+// uma thread de escrita em segundo plano retira as linhas, acrescenta o instante e o nível e as escreve na saída padrão.
+// Quando o buffer circular está cheio a linha é descartada (e contada), para nunca bloquear quem registra.
+//
+// Uso: LOG_INFO("[COORDENADOR] Garfo " << forkId << " liberado");
+// O nível mínimo pode ser fixado na compilação com -DLOG_COMPILE_LEVEL=n (0 = TRACE ... 5 = OFF): as chamadas abaixo dele
+// não geram código. Em tempo de execução, o nível é definido pela configuração "log_level".
+
+enum class LogLevel : uint8_t {
+    TRACE,
+    DEBUG,
+    INFO,
+    WARN,
+    ERROR,
+    OFF
+};
+
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL 0
+#endif
+
+// Verdadeiro se as chamadas do nível especificado geram código. Com o nível 0 não há comparação,
+// que seria sempre verdadeira e geraria o aviso -Wtype-limits
+#if LOG_COMPILE_LEVEL > 0
+#define LOG_COMPILED(level) (static_cast<int>(level) >= LOG_COMPILE_LEVEL)
+#else
+#define LOG_COMPILED(level) true
+#endif
+
+// Nome do nível ("TRACE", "DEBUG", ...), para impressão
+const char* logLevelName(LogLevel level);
+// Converte "trace", "debug", "info", "warn", "error" ou "off" para o nível. Retorna falso se o nome for inválido
+bool parseLogLevel(const std::string& name, LogLevel& level);
+
+// Nível mínimo em tempo de execução
+extern std::atomic<uint8_t> runtimeLogLevel;
+inline void setLogLevel(LogLevel level) { runtimeLogLevel.store(static_cast<uint8_t>(level), std::memory_order_relaxed); }
+inline bool logEnabled(LogLevel level) {
+    return static_cast<uint8_t>(level) >= runtimeLogLevel.load(std::memory_order_relaxed);
+}
+
+// Registra um texto com várias linhas, uma entrada por linha (usado para as estatísticas)
+void logText(LogLevel level, std::string_view text);
+// Escreve todas as linhas pendentes na saída padrão. Chamada automaticamente ao final do processo
+void logFlush();
+
+// Tamanho máximo do texto de uma linha; o excedente é truncado e o fim da linha é marcado com LOG_TRUNCATED
+const size_t LOG_LINE_SIZE = 240;
+const std::string_view LOG_TRUNCATED = " [...]";
+
+// Linha em formação. O texto é montado em um buffer fixo, sem alocações, e enviado ao buffer circular no destrutor
+class LogLine {
+public:
+    explicit LogLine(LogLevel level) : level(level) {}
+    ~LogLine();
+    LogLine(const LogLine&) = delete;
+    LogLine& operator=(const LogLine&) = delete;
+
+    LogLine& operator<<(std::string_view text) { append(text.data(), text.size()); return *this; }
+    LogLine& operator<<(const char* text) { return *this << std::string_view(text); }
+    LogLine& operator<<(const std::string& text) { return *this << std::string_view(text); }
+    LogLine& operator<<(char c) { append(&c, 1); return *this; }
+    LogLine& operator<<(bool value) { return *this << (value ? '1' : '0'); }
+    LogLine& operator<<(double value);
+    template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
+    LogLine& operator<<(T value) {
+        if constexpr (std::is_signed_v<T>) appendSigned(static_cast<long long>(value));
+        else appendUnsigned(static_cast<unsigned long long>(value));
+        return *this;
+    }
+    // Espaço restante na linha, para quem divide um texto longo em várias linhas
+    size_t remaining() const { return LOG_LINE_SIZE - size; }
+
+private:
+    LogLevel level;
+    size_t size = 0;
+    bool truncated = false;
+    char text[LOG_LINE_SIZE];
+
+    void append(const char* data, size_t length);
+    void appendSigned(long long value);
+    void appendUnsigned(unsigned long long value);
+};
+
+#define LOG_AT(level, expr)                                                                   \
+    do {                                                                                      \
+        if (LOG_COMPILED(level) && logEnabled(level)) {                                       \
+            LogLine logLine_(level);                                                          \
+            logLine_ << expr;                                                                 \
+        }                                                                                     \
+    } while (0)
+
+#define LOG_TRACE(expr) LOG_AT(LogLevel::TRACE, expr)
+#define LOG_DEBUG(expr) LOG_AT(LogLevel::DEBUG, expr)
+#define LOG_INFO(expr) LOG_AT(LogLevel::INFO, expr)
+#define LOG_WARN(expr) LOG_AT(LogLevel::WARN, expr)
+#define LOG_ERROR(expr) LOG_AT(LogLevel::ERROR, expr)
+
+#endif
@@ -1,27 +1,85 @@
 #include "message.h"
 
-// Converte o tipo da mensagem, o Id do remetente e o conteúdo em uma única string, separados por "|".
-// Isso permite transmitir a mensagem pela rede
+#include "wire.h"
+
+const char* messageTypeName(MessageType type) {
+    switch (type) {
+        case MessageType::REQUEST_FORK: return "REQUEST_FORK";
+        case MessageType::RELEASE_FORK: return "RELEASE_FORK";
+        case MessageType::FORK_GRANTED: return "FORK_GRANTED";
+        case MessageType::MARKER: return "MARKER";
+        case MessageType::SNAPSHOT_DATA: return "SNAPSHOT_DATA";
+        case MessageType::SNAPSHOT_SUMMARY: return "SNAPSHOT_SUMMARY";
+        case MessageType::ACQUIRE_PAIR: return "ACQUIRE_PAIR";
+        case MessageType::RELEASE_PAIR: return "RELEASE_PAIR";
+        case MessageType::PAIR_GRANTED: return "PAIR_GRANTED";
+        case MessageType::PREEMPT: return "PREEMPT";
+    }
+    return "UNKNOWN";
+}
+
+// Escreve o cabeçalho fixo seguido do conteúdo. Não aloca memória: o chamador fornece o buffer
+size_t Message::encode(char* out) const {
+    char* p = out;
+    putU16(p, WIRE_MAGIC);
+    putU8(p, WIRE_VERSION);
+    putU8(p, static_cast<uint8_t>(type));
+    putI32(p, senderId);
+    putI32(p, targetId);
+    putI32(p, forkId);
+    putU32(p, epoch);
+    putU32(p, static_cast<uint32_t>(content.size()));
+    putBytes(p, content.data(), content.size());
+    return p - out;
+}
+
+// Converte a mensagem para o formato binário, permitindo transmiti-la pela rede
 std::string Message::serialize() const {
-    return std::to_string(static_cast<int>(type)) + "|" + std::to_string(senderId) + "|" + content;
+    std::string data(encodedSize(), '\0');
+    encode(data.data());
+    return data;
 }
 
-// Reconstrói um objeto Message com os valores extraídos no formato : "tipo|senderID|conteúdo"
-Message Message::deserialize(const std::string& data) {
-    std::stringstream ss(data);
-    std::string part;
-    Message msg;
+// Decodifica sem cópias e copia apenas o conteúdo (sem alocação quando ele é vazio)
+bool Message::decode(std::string_view data, Message& msg) {
+    MessageView view;
+    if (!MessageView::decode(data, view)) return false;
+    msg.type = view.type;
+    msg.senderId = view.senderId;
+    msg.targetId = view.targetId;
+    msg.forkId = view.forkId;
+    msg.epoch = view.epoch;
+    msg.content.assign(view.content);
+    return true;
+}
 
-    std::getline(ss, part, '|');
-    msg.type = static_cast<MessageType>(std::stoi(part));
+// Lê o cabeçalho a partir do formato binário, validando a identificação, a versão, o tipo e o tamanho
+bool MessageView::decode(std::string_view data, MessageView& msg) {
+    if (data.size() < MESSAGE_HEADER_SIZE) return false;
 
-    std::getline(ss, part, '|');
-    msg.senderId = std::stoi(part);
+    const char* p = data.data();
+    if (getU16(p) != WIRE_MAGIC) return false;
+    if (getU8(p) != WIRE_VERSION) return false;
+    uint8_t type = getU8(p);
+    if (type > static_cast<uint8_t>(MessageType::PREEMPT)) return false;
 
-    if (std::getline(ss, msg.content)) {
-    } else {
-        msg.content = "";
-    }
+    msg.type = static_cast<MessageType>(type);
+    msg.senderId = getI32(p);
+    msg.targetId = getI32(p);
+    msg.forkId = getI32(p);
+    msg.epoch = getU32(p);
+    uint32_t size = getU32(p);
+    if (size != data.size() - MESSAGE_HEADER_SIZE) return false;
+    msg.content = std::string_view(p, size);
+    return true;
+}
 
-    return msg;
-}
\ No newline at end of file
+// O destinatário fica logo depois do remetente, em uma posição fixa do cabeçalho
+bool Message::peekTarget(std::string_view data, int32_t& targetId) {
+    if (data.size() < MESSAGE_HEADER_SIZE) return false;
+    const char* p = data.data();
+    if (getU16(p) != WIRE_MAGIC || getU8(p) != WIRE_VERSION) return false;
+    p += 1 + 4;
+    targetId = getI32(p);
+    return true;
+}
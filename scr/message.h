@@ -2,24 +2,88 @@
 #define MESSAGE_H
 
 #include <string>
-#include <sstream>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
 
 
-enum class MessageType {
+enum class MessageType : uint8_t {
     REQUEST_FORK,
     RELEASE_FORK,
     FORK_GRANTED,
     MARKER,
-    SNAPSHOT_DATA
+    SNAPSHOT_DATA,
+    // Grafo de espera parcial de uma subárvore, no modo de agregação em árvore
+    SNAPSHOT_SUMMARY,
+    // Modo "acquire_mode=pair": pedido e liberação dos dois garfos do filósofo de uma vez, e a concessão dos dois juntos.
+    // O garfo informado é o esquerdo; o direito é o garfo seguinte no anel
+    ACQUIRE_PAIR,
+    RELEASE_PAIR,
+    PAIR_GRANTED,
+    // Revogação de um garfo pelo coordenador para desfazer um deadlock: o garfo foi passado a outro filósofo
+    // e o filósofo deve pedi-lo novamente
+    PREEMPT
 };
 
+// Identificação e versão do formato binário das mensagens
+const uint16_t WIRE_MAGIC = 0x4450;
+const uint8_t WIRE_VERSION = 3;
+// Tamanho do cabeçalho fixo: magic(2) + versão(1) + tipo(1) + remetente(4) + destinatário(4) + garfo(4) + época(4) + tamanho do conteúdo(4)
+const size_t MESSAGE_HEADER_SIZE = 24;
+
+// ID usado pelo coordenador como remetente das suas mensagens.
+// Fica fora da faixa dos IDs de filósofos, que é limitada pelo número de portas
+const int32_t COORDINATOR_ID = INT32_MAX;
+
+// ID do fragmento "shard" do coordenador (configuração "coordinator_shards"). O fragmento 0 usa COORDINATOR_ID
+inline int32_t coordinatorId(int shard) { return COORDINATOR_ID - shard; }
+// Verifica se o ID é de algum fragmento do coordenador
+inline bool isCoordinatorId(int32_t id) { return id > COORDINATOR_ID - 65536; }
+// Índice do fragmento do coordenador com o ID especificado
+inline int coordinatorShard(int32_t id) { return COORDINATOR_ID - id; }
+
+// Retorna o nome do tipo da mensagem, para impressão
+const char* messageTypeName(MessageType type);
+
 struct Message {
     MessageType type;
-    int senderId;
+    int32_t senderId;
+    // ID do garfo para REQUEST_FORK, RELEASE_FORK e FORK_GRANTED (-1 quando não se aplica)
+    int32_t forkId = -1;
+    // Época (ID) da rodada de snapshot para MARKER e SNAPSHOT_DATA (0 quando não se aplica)
+    uint32_t epoch = 0;
+    // Conteúdo opcional (usado apenas pelo SNAPSHOT_DATA)
     std::string content;
+    // ID do destinatário (filósofo ou COORDINATOR_ID). Um processo que hospeda vários filósofos em uma única porta
+    // usa este campo para entregar a mensagem ao filósofo certo (-1 quando não informado)
+    int32_t targetId = -1;
 
+    // Tamanho da mensagem codificada
+    size_t encodedSize() const { return MESSAGE_HEADER_SIZE + content.size(); }
+    // Codifica a mensagem em "out", que deve ter pelo menos "encodedSize()" bytes. Retorna o número de bytes escritos
+    size_t encode(char* out) const;
+    // Codifica a mensagem em uma nova string
     std::string serialize() const;
-    static Message deserialize(const std::string& data);
+    // Decodifica "data" em "msg". Retorna falso se os dados não formam uma mensagem válida.
+    // Mensagens sem conteúdo são decodificadas sem nenhuma alocação
+    static bool decode(std::string_view data, Message& msg);
+    // Lê apenas o destinatário de uma mensagem codificada, sem decodificá-la. Retorna falso se o cabeçalho for inválido
+    static bool peekTarget(std::string_view data, int32_t& targetId);
+};
+
+// Mensagem decodificada sem cópias: o conteúdo aponta para os dados codificados, que precisam continuar válidos
+// enquanto a mensagem for usada. Usada pelo coordenador para despachar as mensagens recebidas e nos snapshots
+// decodificados em uma arena
+struct MessageView {
+    MessageType type = MessageType::REQUEST_FORK;
+    int32_t senderId = -1;
+    int32_t targetId = -1;
+    int32_t forkId = -1;
+    uint32_t epoch = 0;
+    std::string_view content;
+
+    // Decodifica o cabeçalho de "data" e aponta o conteúdo para o restante. Retorna falso se os dados não formam uma mensagem válida
+    static bool decode(std::string_view data, MessageView& msg);
 };
 
-#endif
\ No newline at end of file
+#endif
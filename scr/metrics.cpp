@@ -0,0 +1,237 @@
+#include "metrics.h"
+
+#include <chrono>
+#include <cstdio>
+#include <csignal>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "log.h"
+
+namespace {
+
+const size_t COUNTER_COUNT = static_cast<size_t>(Counter::COUNT);
+const size_t HISTOGRAM_COUNT = static_cast<size_t>(Histogram::COUNT);
+
+const char* counterNames[COUNTER_COUNT] = {
+    "messages_received", "fork_requests", "fork_grants", "fork_releases",
+    "snapshots_completed", "snapshots_dropped", "in_transit_messages", "deadlocks_detected",
+    "deadlocks_resolved",
+};
+const char* histogramNames[HISTOGRAM_COUNT] = {
+    "fork_grant_wait_ns", "fork_acquire_ns", "snapshot_round_ns", "snapshot_local_ns", "in_transit_per_channel",
+    "send_queue_ns", "deadlock_recovery_ns",
+};
+
+// Cada valor só é escrito pela thread dona do bloco, então "load" seguido de "store" basta;
+// os valores são atômicos apenas para que a leitura por outra thread seja bem definida
+inline void bump(std::atomic<uint64_t>& value, uint64_t amount) {
+    value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+struct HistogramData {
+    std::atomic<uint64_t> buckets[HISTOGRAM_BUCKETS] = {};
+    std::atomic<uint64_t> count{ 0 };
+    std::atomic<uint64_t> sum{ 0 };
+    std::atomic<uint64_t> max{ 0 };
+};
+
+// Bloco de métricas de uma thread
+struct ThreadShard {
+    std::atomic<uint64_t> counters[COUNTER_COUNT] = {};
+    HistogramData histograms[HISTOGRAM_COUNT];
+};
+
+// Blocos de todas as threads. Quando uma thread termina, o seu bloco (com os valores acumulados) é reaproveitado pela próxima
+struct ShardRegistry {
+    std::mutex mtx;
+    std::vector<ThreadShard*> all;
+    std::vector<ThreadShard*> free;
+
+    static ShardRegistry& instance() {
+        static ShardRegistry* registry = new ShardRegistry();
+        return *registry;
+    }
+};
+
+struct ShardHandle {
+    ThreadShard* shard;
+
+    ShardHandle() {
+        ShardRegistry& registry = ShardRegistry::instance();
+        std::lock_guard<std::mutex> lock(registry.mtx);
+        if (!registry.free.empty()) {
+            shard = registry.free.back();
+            registry.free.pop_back();
+        } else {
+            shard = new ThreadShard();
+            registry.all.push_back(shard);
+        }
+    }
+    ~ShardHandle() {
+        ShardRegistry& registry = ShardRegistry::instance();
+        std::lock_guard<std::mutex> lock(registry.mtx);
+        registry.free.push_back(shard);
+    }
+};
+
+ThreadShard& localShard() {
+    thread_local ShardHandle handle;
+    return *handle.shard;
+}
+
+// Valores menores que HISTOGRAM_SUB_BUCKETS têm faixas exatas; acima disso, o expoente escolhe o grupo
+// e os HISTOGRAM_SUB_BITS bits seguintes ao mais significativo escolhem a faixa dentro do grupo
+size_t bucketIndex(uint64_t value) {
+    if (value < HISTOGRAM_SUB_BUCKETS) return static_cast<size_t>(value);
+    int exponent = 63 - __builtin_clzll(value);
+    size_t group = exponent - HISTOGRAM_SUB_BITS + 1;
+    size_t sub = (value >> (exponent - HISTOGRAM_SUB_BITS)) - HISTOGRAM_SUB_BUCKETS;
+    return group * HISTOGRAM_SUB_BUCKETS + sub;
+}
+
+// Valor representativo (meio) da faixa
+uint64_t bucketValue(size_t index) {
+    if (index < HISTOGRAM_SUB_BUCKETS) return index;
+    size_t group = index / HISTOGRAM_SUB_BUCKETS;
+    size_t sub = index % HISTOGRAM_SUB_BUCKETS;
+    int shift = static_cast<int>(group) - 1;
+    uint64_t low = static_cast<uint64_t>(HISTOGRAM_SUB_BUCKETS + sub) << shift;
+    return low + ((uint64_t(1) << shift) >> 1);
+}
+
+std::atomic<bool> reportRequested{ false };
+
+void onReportSignal(int) {
+    reportRequested.store(true, std::memory_order_relaxed);
+}
+
+// Abre o socket de escuta da porta de métricas, aceitando apenas conexões locais por padrão
+int openMetricsSocket(const std::string& host, int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("socket creation failed");
+        return -1;
+    }
+    int opt = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, host.c_str(), &addr.sin_addr) <= 0) addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(fd, 16) < 0) {
+        perror("metrics bind failed");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+} // namespace
+
+void count(Counter counter, uint64_t amount) {
+    bump(localShard().counters[static_cast<size_t>(counter)], amount);
+}
+
+void record(Histogram histogram, uint64_t value) {
+    HistogramData& data = localShard().histograms[static_cast<size_t>(histogram)];
+    bump(data.buckets[bucketIndex(value)], 1);
+    bump(data.count, 1);
+    bump(data.sum, value);
+    if (value > data.max.load(std::memory_order_relaxed)) data.max.store(value, std::memory_order_relaxed);
+}
+
+// Soma os blocos de todas as threads e calcula os percentis percorrendo as faixas acumuladas
+std::string metricsReport() {
+    uint64_t counters[COUNTER_COUNT] = {};
+    std::vector<uint64_t> buckets(HISTOGRAM_COUNT * HISTOGRAM_BUCKETS, 0);
+    uint64_t counts[HISTOGRAM_COUNT] = {}, sums[HISTOGRAM_COUNT] = {}, maxes[HISTOGRAM_COUNT] = {};
+    {
+        ShardRegistry& registry = ShardRegistry::instance();
+        std::lock_guard<std::mutex> lock(registry.mtx);
+        for (const ThreadShard* shard : registry.all) {
+            for (size_t c = 0; c < COUNTER_COUNT; ++c) counters[c] += shard->counters[c].load(std::memory_order_relaxed);
+            for (size_t h = 0; h < HISTOGRAM_COUNT; ++h) {
+                const HistogramData& data = shard->histograms[h];
+                counts[h] += data.count.load(std::memory_order_relaxed);
+                sums[h] += data.sum.load(std::memory_order_relaxed);
+                uint64_t max = data.max.load(std::memory_order_relaxed);
+                if (max > maxes[h]) maxes[h] = max;
+                for (size_t b = 0; b < HISTOGRAM_BUCKETS; ++b)
+                    buckets[h * HISTOGRAM_BUCKETS + b] += data.buckets[b].load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    std::ostringstream out;
+    for (size_t c = 0; c < COUNTER_COUNT; ++c) out << counterNames[c] << " " << counters[c] << "\n";
+    for (size_t h = 0; h < HISTOGRAM_COUNT; ++h) {
+        out << histogramNames[h] << " count=" << counts[h];
+        if (counts[h] > 0) {
+            const double quantiles[] = { 0.5, 0.99, 0.999 };
+            const char* labels[] = { "p50", "p99", "p999" };
+            out << " mean=" << sums[h] / counts[h];
+            size_t b = 0;
+            uint64_t seen = 0;
+            for (int q = 0; q < 3; ++q) {
+                uint64_t rank = static_cast<uint64_t>(quantiles[q] * counts[h]);
+                if (rank >= counts[h]) rank = counts[h] - 1;
+                while (b + 1 < HISTOGRAM_BUCKETS && seen + buckets[h * HISTOGRAM_BUCKETS + b] <= rank) seen += buckets[h * HISTOGRAM_BUCKETS + b++];
+                uint64_t value = bucketValue(b);
+                out << " " << labels[q] << "=" << (value < maxes[h] ? value : maxes[h]);
+            }
+            out << " max=" << maxes[h];
+        }
+        out << "\n";
+    }
+    return out.str();
+}
+
+// A thread espera conexões na porta de métricas (se houver) com um tempo limite, para também verificar os pedidos por SIGUSR1
+void startMetricsExporter(const std::string& owner, const std::string& host, int port) {
+    struct sigaction action{};
+    action.sa_handler = onReportSignal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGUSR1, &action, nullptr);
+
+    int listenFd = port > 0 ? openMetricsSocket(host, port) : -1;
+    if (listenFd >= 0) LOG_INFO("[" << owner << "] Métricas disponíveis na porta " << port);
+
+    std::thread([owner, listenFd] {
+        while (true) {
+            if (listenFd >= 0) {
+                pollfd pfd{ listenFd, POLLIN, 0 };
+                if (poll(&pfd, 1, 200) > 0) {
+                    int client = accept(listenFd, nullptr, nullptr);
+                    if (client >= 0) {
+                        std::string report = "# " + owner + "\n" + metricsReport();
+                        const char* p = report.data();
+                        size_t left = report.size();
+                        while (left > 0) {
+                            ssize_t n = send(client, p, left, MSG_NOSIGNAL);
+                            if (n <= 0) break;
+                            p += n;
+                            left -= n;
+                        }
+                        close(client);
+                    }
+                }
+            } else {
+                std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            }
+            if (reportRequested.exchange(false, std::memory_order_relaxed)) {
+                std::string report = "# " + owner + "\n" + metricsReport();
+                std::fwrite(report.data(), 1, report.size(), stderr);
+            }
+        }
+    }).detach();
+}
@@ -0,0 +1,65 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <string>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+
+// Instrumentação de baixo custo: contadores e histogramas de latência no estilo HDR.
+// Cada thread escreve apenas no seu próprio bloco de métricas (sem operações atômicas de leitura-modificação-escrita
+// nem compartilhamento de linhas de cache); os blocos de todas as threads são somados apenas na leitura.
+//
+// As métricas podem ser lidas por uma porta TCP local (configuração "metrics_port": cada conexão recebe o relatório
+// em texto e é fechada) ou enviando SIGUSR1 ao processo, que imprime o relatório na saída de erro.
+
+enum class Counter {
+    MESSAGES_RECEIVED,
+    FORK_REQUESTS,
+    FORK_GRANTS,
+    FORK_RELEASES,
+    SNAPSHOTS_COMPLETED,
+    SNAPSHOTS_DROPPED,
+    IN_TRANSIT_MESSAGES,
+    DEADLOCKS_DETECTED,
+    DEADLOCKS_RESOLVED,
+    COUNT
+};
+
+enum class Histogram {
+    // Coordenador: tempo entre o pedido de um garfo e a sua concessão (0 quando o garfo estava livre)
+    FORK_GRANT_WAIT_NS,
+    // Filósofo: tempo entre pedir os garfos e ter os dois (laço de espera em "runLoop")
+    FORK_ACQUIRE_NS,
+    // Coordenador: duração de uma rodada de snapshot, do envio dos marcadores ao último snapshot recebido
+    SNAPSHOT_ROUND_NS,
+    // Filósofo: tempo entre o primeiro e o último marcador de uma rodada
+    SNAPSHOT_LOCAL_NS,
+    // Número de mensagens em trânsito gravadas em cada canal, por rodada
+    IN_TRANSIT_PER_CHANNEL,
+    // Filósofo: tempo entre enfileirar uma mensagem para envio assíncrono e entregá-la ao transporte
+    SEND_QUEUE_NS,
+    // Coordenador: tempo entre a formação de um deadlock (o pedido mais recente do ciclo) e a revogação do garfo da vítima
+    DEADLOCK_RECOVERY_NS,
+    COUNT
+};
+
+// Precisão dos histogramas: cada potência de 2 é dividida em 2^HISTOGRAM_SUB_BITS faixas (erro relativo de ~3%)
+const int HISTOGRAM_SUB_BITS = 5;
+const size_t HISTOGRAM_SUB_BUCKETS = size_t(1) << HISTOGRAM_SUB_BITS;
+const size_t HISTOGRAM_BUCKETS = (64 - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_BUCKETS;
+
+// Incrementa o contador no bloco da thread atual
+void count(Counter counter, uint64_t amount = 1);
+// Registra um valor no histograma do bloco da thread atual
+void record(Histogram histogram, uint64_t value);
+
+// Gera o relatório em texto com todos os contadores e, para cada histograma, o número de amostras, a média, p50, p99, p999 e o máximo
+std::string metricsReport();
+
+// Instala o tratamento de SIGUSR1 e, se "port" for maior que 0, abre a porta de métricas.
+// Cria uma thread que atende as conexões e os pedidos de relatório. "owner" identifica o processo no relatório
+void startMetricsExporter(const std::string& owner, const std::string& host, int port);
+
+#endif
@@ -0,0 +1,113 @@
+#include "partial_graph.h"
+
+#include <unordered_map>
+
+#include "wire.h"
+
+// Tamanho do cabeçalho fixo: versão(1) + reservado(3) + filósofos(4) + famintos(4) + arestas(4) + esperas(4) + posses(4)
+static const size_t PARTIAL_GRAPH_HEADER_SIZE = 24;
+
+// Segue as mesmas regras da detecção a partir dos snapshots completos: só filósofos famintos geram esperas
+// e só garfos de filósofos famintos podem fechar um ciclo
+PartialGraph PartialGraph::fromSnapshot(int philosopherId, const Snapshot& snap, const std::function<int(int forkId)>& grantChannel) {
+    PartialGraph graph;
+    graph.philosophers = 1;
+    if (snap.localState != PhilosopherState::HUNGRY) return graph;
+
+    graph.hungry = 1;
+    // Um garfo revogado em trânsito volta a ser pedido; uma nova concessão só pode estar depois da revogação no canal
+    if (snap.holdsFork(grantChannel(snap.leftForkId), snap.leftForkId)) graph.holders.push_back({ snap.leftForkId, philosopherId });
+    else if (!snap.grantedInTransit(grantChannel(snap.leftForkId), snap.leftForkId)) graph.waits.push_back({ philosopherId, snap.leftForkId });
+    if (snap.holdsFork(grantChannel(snap.rightForkId), snap.rightForkId)) graph.holders.push_back({ snap.rightForkId, philosopherId });
+    else if (!snap.grantedInTransit(grantChannel(snap.rightForkId), snap.rightForkId)) graph.waits.push_back({ philosopherId, snap.rightForkId });
+    return graph;
+}
+
+void PartialGraph::merge(const PartialGraph& other) {
+    philosophers += other.philosophers;
+    hungry += other.hungry;
+    edges.insert(edges.end(), other.edges.begin(), other.edges.end());
+    waits.insert(waits.end(), other.waits.begin(), other.waits.end());
+    holders.insert(holders.end(), other.holders.begin(), other.holders.end());
+}
+
+// As esperas e posses restantes são compactadas no próprio vetor, sem alocar novos
+void PartialGraph::resolve(const std::function<bool(int forkId)>& closed) {
+    std::unordered_map<int32_t, int32_t> ownerOf;
+    ownerOf.reserve(holders.size());
+    for (const Holder& h : holders) ownerOf[h.forkId] = h.owner;
+
+    size_t keptWaits = 0;
+    for (const Wait& w : waits) {
+        auto it = ownerOf.find(w.forkId);
+        if (it != ownerOf.end()) edges.emplace_back(w.waiter, it->second);
+        else if (!closed(w.forkId)) waits[keptWaits++] = w;
+    }
+    waits.resize(keptWaits);
+
+    size_t keptHolders = 0;
+    for (const Holder& h : holders) {
+        if (!closed(h.forkId)) holders[keptHolders++] = h;
+    }
+    holders.resize(keptHolders);
+}
+
+// Cada aresta, espera e posse é gravada como dois inteiros de 4 bytes
+std::string PartialGraph::serialize() const {
+    std::string data(PARTIAL_GRAPH_HEADER_SIZE + 8 * (edges.size() + waits.size() + holders.size()), '\0');
+    char* p = data.data();
+    putU8(p, PARTIAL_GRAPH_VERSION);
+    putU8(p, 0);
+    putU16(p, 0);
+    putU32(p, philosophers);
+    putU32(p, hungry);
+    putU32(p, static_cast<uint32_t>(edges.size()));
+    putU32(p, static_cast<uint32_t>(waits.size()));
+    putU32(p, static_cast<uint32_t>(holders.size()));
+    for (const auto& [from, to] : edges) {
+        putI32(p, from);
+        putI32(p, to);
+    }
+    for (const Wait& w : waits) {
+        putI32(p, w.waiter);
+        putI32(p, w.forkId);
+    }
+    for (const Holder& h : holders) {
+        putI32(p, h.forkId);
+        putI32(p, h.owner);
+    }
+    return data;
+}
+
+// O tamanho total é conferido a partir das contagens do cabeçalho antes de ler qualquer entrada
+bool PartialGraph::decode(std::string_view data, PartialGraph& graph) {
+    if (data.size() < PARTIAL_GRAPH_HEADER_SIZE) return false;
+
+    const char* p = data.data();
+    if (getU8(p) != PARTIAL_GRAPH_VERSION) return false;
+    getU8(p);
+    getU16(p);
+    graph.philosophers = getU32(p);
+    graph.hungry = getU32(p);
+    uint64_t edgeCount = getU32(p);
+    uint64_t waitCount = getU32(p);
+    uint64_t holderCount = getU32(p);
+    if (data.size() != PARTIAL_GRAPH_HEADER_SIZE + 8 * (edgeCount + waitCount + holderCount)) return false;
+
+    graph.edges.resize(edgeCount);
+    for (auto& [from, to] : graph.edges) {
+        from = getI32(p);
+        to = getI32(p);
+    }
+    graph.waits.resize(waitCount);
+    for (Wait& w : graph.waits) {
+        w.waiter = getI32(p);
+        w.forkId = getI32(p);
+    }
+    graph.holders.resize(holderCount);
+    for (Holder& h : graph.holders) {
+        h.forkId = getI32(p);
+        h.owner = getI32(p);
+    }
+    return true;
+}
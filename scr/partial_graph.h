@@ -0,0 +1,55 @@
+#ifndef PARTIAL_GRAPH_H
+#define PARTIAL_GRAPH_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <functional>
+#include <cstdint>
+
+#include "snapshot.h"
+
+
+// Versão do formato binário do grafo parcial
+const uint8_t PARTIAL_GRAPH_VERSION = 1;
+
+// Resumo compacto dos snapshots de uma subárvore da árvore de agregação.
+// Em vez de encaminhar os snapshots completos, cada filósofo intermediário junta o seu resumo com os dos filhos,
+// transforma em arestas as esperas cujo dono do garfo já é conhecido e encaminha apenas o que ainda pode ser
+// casado fora da subárvore. O coordenador recebe um resumo por filho da raiz e só precisa juntar os resumos.
+struct PartialGraph {
+    // Filósofo faminto "waiter" esperando pelo garfo "forkId", cujo dono ainda não é conhecido
+    struct Wait {
+        int32_t waiter;
+        int32_t forkId;
+    };
+    // Garfo "forkId" possuído pelo filósofo faminto "owner"
+    struct Holder {
+        int32_t forkId;
+        int32_t owner;
+    };
+
+    // Número de filósofos e de filósofos famintos cobertos pelo resumo
+    uint32_t philosophers = 0;
+    uint32_t hungry = 0;
+    // Arestas do grafo de espera já resolvidas (filósofo que espera, dono do garfo)
+    std::vector<std::pair<int32_t, int32_t>> edges;
+    std::vector<Wait> waits;
+    std::vector<Holder> holders;
+
+    // Constrói o resumo de um único filósofo a partir do seu snapshot.
+    // Um garfo cuja concessão está em trânsito no canal do fragmento do coordenador que o arbitra ("grantChannel") não é considerado esperado
+    static PartialGraph fromSnapshot(int philosopherId, const Snapshot& snap, const std::function<int(int forkId)>& grantChannel);
+    // Junta outro resumo a este
+    void merge(const PartialGraph& other);
+    // Transforma em arestas as esperas cujo dono do garfo é conhecido. Esperas e posses de garfos para os quais
+    // "closed" retorna verdadeiro (todos os filósofos que usam o garfo estão cobertos) são descartadas
+    void resolve(const std::function<bool(int forkId)>& closed);
+
+    // Serializa o resumo no formato binário para a transmissão pela rede
+    std::string serialize() const;
+    // Decodifica o formato binário no resumo. Retorna falso se os dados forem inválidos
+    static bool decode(std::string_view data, PartialGraph& graph);
+};
+
+#endif
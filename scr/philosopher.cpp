@@ -1,11 +1,27 @@
 #include "philosopher.h"
 
-// Inicializa o ID do filósofo, e determina os IDs dos garfos esquerdo e direito com base no seu próprio ID e no número total de filósofos.
+// Inicializa o ID do filósofo, e determina os IDs dos garfos esquerdo e direito com base no seu próprio ID e no número total de filósofos configurado.
 // Imprime uma mensagem de inicialização
-Philosopher::Philosopher(int id) : id(id) {
+Philosopher::Philosopher(int id, const Config& config, Transport* transport)
+    : id(id), config(config), connections("Filósofo " + std::to_string(id), config.host), transport(transport ? transport : &connections),
+      neighbours(config.neighbours(id)) {
+    if (config.sendThreads > 0) {
+        executor = std::make_unique<Executor>("Filósofo " + std::to_string(id), config.sendThreads);
+        outbox = std::make_unique<AsyncTransport>("Filósofo " + std::to_string(id), *this->transport, *executor);
+        this->transport = outbox.get();
+    }
     leftFork = id;
-    rightFork = (id + 1) % NUM_PHILOSOPHERS;
-    std::cout << "[Filósofo " << id << "] Inicializado. Garfo esquerdo: " << leftFork << ", Garfo direito: " << rightFork << "\n" << std::flush;
+    rightFork = (id + 1) % config.numPhilosophers;
+    inputChannels = neighbours;
+    for (int s = 0; s < config.coordinatorShards; ++s) inputChannels.push_back(coordinatorId(s));
+    channelLogs.resize(inputChannels.size());
+    for (size_t i = 0; i < inputChannels.size(); ++i) channelIndex[inputChannels[i]] = i;
+    if (config.aggregationFanout > 0) {
+        aggregationChildren = config.aggregationChildren(id);
+        int parent = config.aggregationParent(id);
+        aggregationParentId = parent < 0 ? COORDINATOR_ID : parent;
+    }
+    LOG_INFO("[Filósofo " << id << "] Inicializado. Garfo esquerdo: " << leftFork << ", Garfo direito: " << rightFork);
 }
 
 // Cria uma thread para o recebimento de mensagens e chama "runLoop" na thread 
@@ -17,223 +33,381 @@ void Philosopher::start() {
 }
 
 // Simula o ciclo de vida de um filósofo: pensando, faminto e comendo.
-// Gerencia as transições de estado, solicita e libera garfos, e espera pelas condições necessárias (posse de ambos os garfos) para comer.
+// Os tempos de pensar e comer são esperas reais; a espera pelos garfos é feita na variável de condição até que ambos sejam concedidos.
+// A verificação dos garfos e a passagem para "comendo" acontecem sob o mesmo lock, para que um garfo revogado (PREEMPT) entre
+// as duas faça o filósofo voltar a esperar em vez de comer sem ele.
 void Philosopher::runLoop() {
     using namespace std::chrono_literals;
 
     while (true) {
-        {
-            std::unique_lock<std::mutex> lock(mtx);
-            state = "thinking";
-        }
+        LOG_DEBUG("[Filósofo " << id << "] Pensando...");
+        std::this_thread::sleep_for(std::chrono::milliseconds(config.thinkMs)); // Tempo de pensamento
 
-        std::cout << "[Filósofo " << id << "] Pensando...\n" << std::flush;
-        std::this_thread::sleep_for(2s); // Tempo de pensamento
+        auto hungrySince = std::chrono::steady_clock::now();
+        becomeHungry();
 
         {
             std::unique_lock<std::mutex> lock(mtx);
-            state = "hungry";
+            while (!startEatingLocked()) {
+                LOG_DEBUG("[Filósofo " << id << "] Aguardando garfos (L:" << hasLeft << ", R:" << hasRight << ")...");
+                cv.wait(lock);
+            }
         }
+        record(Histogram::FORK_ACQUIRE_NS, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - hungrySince).count());
 
-        requestFork(leftFork);
-        requestFork(rightFork);
+        LOG_DEBUG("[Filósofo " << id << "] Comendo...");
+        std::this_thread::sleep_for(std::chrono::milliseconds(config.eatMs)); // Tempo de alimentação
 
-        {
-            std::unique_lock<std::mutex> lock(mtx);
-            while (!(hasLeft && hasRight)) {
-                std::cout << "[Filósofo " << id << "] Aguardando garfos (L:" << hasLeft << ", R:" << hasRight << ")...\n" << std::flush;
-                cv.wait(lock);
-            }
-            state = "eating";
+        finishEating();
+        if (logEnabled(LogLevel::INFO)) {
+            std::ostringstream stats;
+            connections.printStats(stats);
+            logText(LogLevel::INFO, stats.str());
         }
+    }
+}
+
+// O estado muda antes dos pedidos, para que um snapshot iniciado depois deles já registre o filósofo como faminto
+void Philosopher::becomeHungry() {
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        state = PhilosopherState::HUNGRY;
+    }
+    if (config.acquireMode == AcquireMode::PAIR) {
+        requestPair();
+        return;
+    }
+    requestFork(leftFork);
+    requestFork(rightFork);
+}
+
+bool Philosopher::tryStartEating() {
+    std::unique_lock<std::mutex> lock(mtx);
+    return startEatingLocked();
+}
 
-        std::cout << "[Filósofo " << id << "] Comendo...\n" << std::flush;
-        std::this_thread::sleep_for(2s); // Tempo de alimentação
+bool Philosopher::startEatingLocked() {
+    if (state != PhilosopherState::HUNGRY || !(hasLeft && hasRight)) return false;
+    state = PhilosopherState::EATING;
+    return true;
+}
 
+// A posse dos garfos só muda sob o lock, junto com o estado, como nas concessões e revogações tratadas em "handleMessage"
+void Philosopher::finishEating() {
+    if (config.acquireMode == AcquireMode::PAIR) {
+        releasePair();
+    } else {
         releaseFork(leftFork);
         releaseFork(rightFork);
     }
+    std::unique_lock<std::mutex> lock(mtx);
+    hasLeft = false;
+    hasRight = false;
+    state = PhilosopherState::THINKING;
 }
 
-// O filósofo abre um socket, vincula-o à sua porta específica ("BASE_PORT + id") e fica aguardando conexões e mensagens.
-// Ao receber uma mensagem, ele a deserializa e a despacha para a função "handleMessage".
+// O filósofo escuta na sua porta específica (porta base + id) pelo transporte configurado
+// e despacha cada mensagem recebida para a função "handleMessage".
 void Philosopher::listenLoop() {
-    int sockfd = socket(AF_INET, SOCK_STREAM, 0);
-    sockaddr_in addr{};
-    addr.sin_family = AF_INET;
-    addr.sin_port = htons(BASE_PORT + id);
-    addr.sin_addr.s_addr = INADDR_ANY;
-
-    int enable = 1;
-    if (setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(int)) < 0) {
-        perror("setsockopt(SO_REUSEADDR) failed on philosopher");
+    LOG_INFO("[Filósofo " << id << "] Aguardando mensagens na porta " << config.philosopherPort(id) << "...");
+    if (!transport->listen(config.philosopherPort(id), [this](std::string_view data) { handleMessage(data); })) {
+        LOG_ERROR("[Filósofo " << id << "] Não foi possível escutar na porta " << config.philosopherPort(id));
     }
+}
 
-    bind(sockfd, (sockaddr*)&addr, sizeof(addr));
-    listen(sockfd, 20);
-    std::cout << "[Filósofo " << id << "] Aguardando mensagens na porta " << BASE_PORT + id << "...\n" << std::flush;
+// Envia mensagem do tipo "REQUEST_FORK" para o fragmento do coordenador que arbitra o garfo, solicitando o garfo
+void Philosopher::requestFork(int forkId) {
+    sendMessage(coordinatorId(config.forkShard(forkId)), Message{ MessageType::REQUEST_FORK, id, forkId });
+    LOG_DEBUG("[Filósofo " << id << "] Solicitou garfo " << forkId);
+}
 
-    while (true) {
-        sockaddr_in cli{};
-        socklen_t clilen = sizeof(cli);
-        int client = accept(sockfd, (sockaddr*)&cli, &clilen);
-        if (client < 0) {
-            perror("accept failed on philosopher");
-            continue;
-        }
-        char buffer[1024] = {0};
-        int valread = read(client, buffer, 1024);
-        if (valread < 0) {
-            perror("read failed on philosopher");
-            close(client);
-            continue;
-        }
-        std::string received_data(buffer, valread);
+// Envia mensagem do tipo "RELEASE_FORK" para o fragmento do coordenador que arbitra o garfo, liberando o garfo
+void Philosopher::releaseFork(int forkId) {
+    sendMessage(coordinatorId(config.forkShard(forkId)), Message{ MessageType::RELEASE_FORK, id, forkId });
+    LOG_DEBUG("[Filósofo " << id << "] Liberou garfo " << forkId);
+}
 
-        handleMessage(received_data);
-        close(client);
-    }
-    close(sockfd);
+// Envia mensagem do tipo "ACQUIRE_PAIR" para o coordenador, solicitando os dois garfos (identificados pelo esquerdo)
+void Philosopher::requestPair() {
+    sendMessage(coordinatorId(0), Message{ MessageType::ACQUIRE_PAIR, id, leftFork });
+    LOG_DEBUG("[Filósofo " << id << "] Solicitou os garfos " << leftFork << " e " << rightFork);
 }
 
-// Envia mensagem do tipo "REQUEST_FORK" para o coordenador, solicitando um garfo ao coordenador
-void Philosopher::requestFork(int forkId) {
-    Message msg{ MessageType::REQUEST_FORK, id, std::to_string(forkId) };
-    sendMessage(COORDINATOR_PORT, msg.serialize());
-    std::cout << "[Filósofo " << id << "] Solicitou garfo " << forkId << "\n" << std::flush;
+// Envia mensagem do tipo "RELEASE_PAIR" para o coordenador, liberando os dois garfos
+void Philosopher::releasePair() {
+    sendMessage(coordinatorId(0), Message{ MessageType::RELEASE_PAIR, id, leftFork });
+    LOG_DEBUG("[Filósofo " << id << "] Liberou os garfos " << leftFork << " e " << rightFork);
 }
 
-// Envia mensagem do tipo "RELEASE_FORK" para o coordenador, liberando um garfo ao coordenador
-void Philosopher::releaseFork(int forkId) {
-    Message msg{ MessageType::RELEASE_FORK, id, std::to_string(forkId) };
-    sendMessage(COORDINATOR_PORT, msg.serialize());
-    std::cout << "[Filósofo " << id << "] Liberou garfo " << forkId << "\n" << std::flush;
-    if (forkId == leftFork) hasLeft = false;
-    else if (forkId == rightFork) hasRight = false;
-}
-
-// Cria um socket para se conectar à porta e endereço especificados para envio de mensagens
-void Philosopher::sendMessage(int port, const std::string& data) {
-    int sock = socket(AF_INET, SOCK_STREAM, 0);
-    if (sock < 0) {
-        perror("socket creation failed on philosopher");
-        return;
+// Codifica a mensagem com o destinatário e a envia pelo transporte para a porta em que ele escuta. Com envios assíncronos ela só é enfileirada,
+// então pode ser chamada com o lock "mtx" adquirido sem atrasar o tratamento das próximas mensagens (como as concessões de garfos).
+// Mensagens sem conteúdo (pedidos, liberações e marcadores) são codificadas na pilha, sem alocação
+void Philosopher::sendMessage(int targetId, Message msg) {
+    msg.targetId = targetId;
+    int port = config.participantPort(targetId);
+    bool sent;
+    if (msg.content.empty()) {
+        char buffer[MESSAGE_HEADER_SIZE];
+        sent = transport->send(port, std::string_view(buffer, msg.encode(buffer)));
+    } else {
+        sent = transport->send(port, msg.serialize());
     }
-    sockaddr_in addr{};
-    addr.sin_family = AF_INET;
-    addr.sin_port = htons(port);
-    if (inet_pton(AF_INET, LOCALHOST, &addr.sin_addr) <= 0) {
-        perror("Invalid address/ Address not supported on philosopher");
-        close(sock);
-        return;
+    if (!sent) {
+        LOG_WARN("[Filósofo " << id << "] Falha ao enviar mensagem para a porta " << port);
     }
+}
 
-    if (connect(sock, (sockaddr*)&addr, sizeof(addr)) < 0) {
-        close(sock);
+// Deserializa a mensagem e a processa de acordo com o seu tipo.
+// Para cada rodada de snapshot em andamento, as mensagens que não são marcadores e chegam por um canal que ainda não
+// recebeu o marcador da rodada são armazenadas como mensagens em trânsito daquela rodada.
+void Philosopher::handleMessage(std::string_view data) {
+    Message msg;
+    if (!Message::decode(data, msg)) {
+        LOG_WARN("[Filósofo " << id << "] Mensagem inválida recebida. Ignorando.");
         return;
     }
-    send(sock, data.c_str(), data.size(), 0);
-    close(sock);
-}
+    count(Counter::MESSAGES_RECEIVED);
 
-// Deserializa a mensagem e a processa de acordo com o seu tipo.
-// Se estiver no modo de gravação de snapshot ("recording"), as mensagens que não são marcadores são armazenadas como mensagens em trânsito.
-void Philosopher::handleMessage(const std::string& data) {
-    Message msg = Message::deserialize(data);
-
-    if (collectingSnapshot) {
-        // Se estiver coletando snapshot, armazena mensagens em trânsito
-        if (msg.type != MessageType::MARKER) {
-            messagesInTransit[msg.senderId].push_back(data);
+    if (msg.type == MessageType::MARKER) {
+         // Chama a função para lidar com a mensagem de marcador
+        handleMarker(msg.senderId, msg.epoch);
+        return;
+    }
+    if (msg.type == MessageType::SNAPSHOT_SUMMARY) {
+        // Resumo da subárvore de um filho na árvore de agregação. Faz parte do protocolo de snapshot e não é gravado
+        PartialGraph graph;
+        if (!PartialGraph::decode(msg.content, graph)) {
+            LOG_WARN("[Filósofo " << id << "] Resumo de snapshot inválido do filósofo " << msg.senderId << ". Ignorando.");
+            return;
         }
+        std::unique_lock<std::mutex> lock(mtx);
+        contributeToAggregation(msg.epoch, graph, false);
+        return;
     }
 
+    // Adquire um lock apenas para o efeito da mensagem e para numerá-la, de forma atômica em relação ao registro do estado local:
+    // ela está em trânsito em uma rodada se o seu número for maior que o da rodada. A gravação em si é feita depois, sem o lock,
+    // com um único acréscimo ao registro do canal, que é compartilhado por todas as rodadas que o gravam e só é usado por esta thread.
+    // A mensagem é movida para o registro; o tratamento abaixo usa apenas o tipo e o garfo, guardados antes
+    const MessageType type = msg.type;
+    const int fork = msg.forkId;
+    auto channel = channelIndex.find(msg.senderId);
+    ChannelLog* log = channel != channelIndex.end() ? &channelLogs[channel->second] : nullptr;
+    bool preempted = false;
+    std::unique_lock<std::mutex> lock(mtx);
+    const uint64_t seq = ++receiveSeq;
+    const bool recorded = log && log->recording > 0;
 
-    if (msg.type == MessageType::FORK_GRANTED) {
-        // Adquire um lock
-        std::unique_lock<std::mutex> lock(mtx); 
+    if (type == MessageType::FORK_GRANTED) {
          // Obtém o ID do garfo concedido
-        int fork = std::stoi(msg.content);
         if (fork == leftFork) {
             // Filósofo agora possui o garfo esquerdo
             hasLeft = true; 
-            std::cout << "[Filósofo " << id << "] Recebeu garfo esquerdo " << fork << "\n" << std::flush;
+            LOG_DEBUG("[Filósofo " << id << "] Recebeu garfo esquerdo " << fork);
         }
         else if (fork == rightFork) {
             // Filósofo agora possui o garfo direito
             hasRight = true;
-            std::cout << "[Filósofo " << id << "] Recebeu garfo direito " << fork << "\n" << std::flush;
+            LOG_DEBUG("[Filósofo " << id << "] Recebeu garfo direito " << fork);
         }
          // Notifica outras threads
         cv.notify_all();
-    } else if (msg.type == MessageType::MARKER) {
-         // Chama a função para lidar com a mensagem de marcador
-        handleMarker(msg.senderId);
+    } else if (type == MessageType::PAIR_GRANTED) {
+        // Os dois garfos chegam juntos
+        hasLeft = true;
+        hasRight = true;
+        LOG_DEBUG("[Filósofo " << id << "] Recebeu os garfos " << leftFork << " e " << rightFork);
+        cv.notify_all();
+    } else if (type == MessageType::PREEMPT) {
+        // O coordenador revogou o garfo para desfazer um deadlock: ele volta a ser pedido, fora do lock.
+        // Só uma vítima com fome e que possui o garfo pode perdê-lo; qualquer outra revogação é ignorada
+        if (state == PhilosopherState::HUNGRY && ((fork == leftFork && hasLeft) || (fork == rightFork && hasRight))) {
+            if (fork == leftFork) hasLeft = false;
+            else hasRight = false;
+            LOG_INFO("[Filósofo " << id << "] Garfo " << fork << " revogado pelo coordenador. Pedindo novamente.");
+            preempted = true;
+        }
     }
+    lock.unlock();
+
+    if (recorded) {
+        log->messages.push_back(std::move(msg));
+        log->seqs.push_back(seq);
+    } else if (log && !log->messages.empty()) {
+        // Nenhuma rodada grava o canal: o que restou no registro é de rodadas descartadas
+        log->messages.clear();
+        log->seqs.clear();
+    }
+    if (preempted) requestFork(fork);
 }
 
-// Esta função implementa a lógica do algoritmo de snapshot distribuído.
-// Quando o *primeiro* marcador é recebido:
+// Esta função implementa a lógica do algoritmo de snapshot distribuído, separadamente para cada época.
+// Quando o *primeiro* marcador de uma época é recebido:
 //  -> 1: O filósofo salva seu estado local e começa a gravar as mensagens em trânsito em todos os seus canais de entrada.
-//  -> 2: O filósofo envia um marcador para todos os seus *canais de saída*.
-// Para marcadores subsequentes (enquanto já está gravando) apenas registra que o marcador foi recebido de um novo canal.
-// Quando marcadores são recebidos de *todos* os outros filósofos, o filósofo para de gravar mensagens e envia seu snapshot completo (estado local + mensagens em trânsito) para o coordenador.
-void Philosopher::handleMarker(int fromId) {
+//  -> 2: O filósofo envia um marcador da mesma época para todos os seus *canais de saída*.
+// Para marcadores subsequentes da época apenas registra que o marcador foi recebido de um novo canal (que deixa de ser gravado).
+// Quando marcadores da época são recebidos de *todos* os canais de entrada, o filósofo envia o snapshot completo da rodada (estado local + mensagens em trânsito) para o coordenador.
+// Se houver mais rodadas em andamento do que o permitido, a mais antiga é descartada.
+void Philosopher::handleMarker(int fromId, uint32_t epoch) {
     std::unique_lock<std::mutex> lock(mtx);
+    if (epoch < oldestAcceptedEpoch) return;
 
-    if (!recording) {
+    auto it = rounds.find(epoch);
+    if (it == rounds.end()) {
         // P1: Salva o estado local
-        recording = true;
-        snapshot.localState = state;
-        snapshot.hasLeftFork = hasLeft;
-        snapshot.hasRightFork = hasRight;
-        snapshot.leftForkId = leftFork;
-        snapshot.rightForkId = rightFork;
-
-        markersReceivedFrom.insert(fromId);
+        SnapshotRound& round = rounds[epoch];
+        round.startedAt = std::chrono::steady_clock::now();
+        round.snapshot.localState = state;
+        round.snapshot.hasLeftFork = hasLeft;
+        round.snapshot.hasRightFork = hasRight;
+        round.snapshot.leftForkId = leftFork;
+        round.snapshot.rightForkId = rightFork;
+        // Começa a gravar todos os canais de entrada: as mensagens recebidas a partir de agora estão em trânsito na rodada
+        round.startSeq = receiveSeq;
+        for (ChannelLog& log : channelLogs) ++log.recording;
+        closeChannel(round, fromId);
 
         // P2: Envia o marcador para todos os outros canais de saída
-        sendMarkerToOthers();
+        sendMarkerToOthers(epoch);
+
+        if (rounds.size() > static_cast<size_t>(config.maxInflightSnapshots)) {
+            count(Counter::SNAPSHOTS_DROPPED);
+            LOG_WARN("[Filósofo " << id << "] Descartando rodada de snapshot " << rounds.begin()->first << " (muitas rodadas em andamento)");
+            oldestAcceptedEpoch = rounds.begin()->first + 1;
+            dropRound(rounds.begin());
+        }
+        it = rounds.find(epoch);
+        if (it == rounds.end()) return;
     } else {
-        markersReceivedFrom.insert(fromId);
+        closeChannel(it->second, fromId);
     }
 
-    if (markersReceivedFrom.size() == NUM_PHILOSOPHERS - 1) {
-        sendSnapshotToCoordinator();
-        // Reseta o estado para o próximo snapshot
-        recording = false;
-        markersReceivedFrom.clear();
-        messagesInTransit.clear();
+    if (it->second.markersReceivedFrom.size() == expectedMarkers()) {
+        record(Histogram::SNAPSHOT_LOCAL_NS, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - it->second.startedAt).count());
+        for (const auto& [from, msgs] : it->second.snapshot.channelMessages) {
+            record(Histogram::IN_TRANSIT_PER_CHANNEL, msgs.size());
+            count(Counter::IN_TRANSIT_MESSAGES, msgs.size());
+        }
+        count(Counter::SNAPSHOTS_COMPLETED);
+        if (config.aggregationFanout > 0)
+            contributeToAggregation(epoch, PartialGraph::fromSnapshot(id, it->second.snapshot, [this](int forkId) { return coordinatorId(config.forkShard(forkId)); }), true);
+        else
+            sendSnapshotToCoordinator(epoch, it->second.snapshot);
+        // Encerra a rodada
+        rounds.erase(it);
     }
 }
 
-// Cria uma mensagem do tipo "MARKER" e a envia para cada filósofo, exceto para si mesmo.
-void Philosopher::sendMarkerToOthers() {
-    Message marker{ MessageType::MARKER, id, "" };
-    for (int i = 0; i < NUM_PHILOSOPHERS; ++i) {
-        if (i != id) {
-            sendMessage(BASE_PORT + i, marker.serialize());
+// Marcadores de remetentes que não são canais de entrada são ignorados: contá-los poderia completar a rodada antes
+// de todos os canais serem fechados, perdendo as suas mensagens em trânsito.
+// Chamada pela thread que recebe as mensagens do canal, a única que usa o seu registro, então as mensagens gravadas antes do marcador
+// já estão nele. As mensagens da rodada são as numeradas depois do início dela: sem outra rodada gravando o canal, são movidas
+// para o snapshot (trocando o buffer inteiro, sem cópias, quando são o registro todo); só as que também estão em trânsito
+// em outra rodada são copiadas. Em seguida o registro é cortado até o início da rodada mais antiga que ainda o grava
+void Philosopher::closeChannel(SnapshotRound& round, int fromId) {
+    auto channel = channelIndex.find(fromId);
+    if (channel == channelIndex.end()) {
+        LOG_WARN("[Filósofo " << id << "] Marcador de " << fromId << ", que não é um canal de entrada. Ignorando.");
+        return;
+    }
+    if (!round.markersReceivedFrom.insert(fromId).second) return;
+    ChannelLog& log = channelLogs[channel->second];
+    --log.recording;
+
+    uint64_t neededByOthers = UINT64_MAX;
+    for (const auto& [epoch, other] : rounds) {
+        if (&other != &round && !other.markersReceivedFrom.count(fromId)) neededByOthers = std::min(neededByOthers, other.startSeq);
+    }
+    size_t first = std::upper_bound(log.seqs.begin(), log.seqs.end(), round.startSeq) - log.seqs.begin();
+    if (first < log.messages.size()) {
+        std::vector<Message>& messages = round.snapshot.channelMessages[fromId];
+        if (neededByOthers >= log.seqs.back() && first == 0) {
+            messages.swap(log.messages);
+        } else if (neededByOthers >= log.seqs.back()) {
+            messages.assign(std::make_move_iterator(log.messages.begin() + first), std::make_move_iterator(log.messages.end()));
+        } else {
+            messages.assign(log.messages.begin() + first, log.messages.end());
         }
     }
+    size_t needed = std::upper_bound(log.seqs.begin(), log.seqs.end(), neededByOthers) - log.seqs.begin();
+    if (needed >= log.seqs.size()) {
+        log.messages.clear();
+        log.seqs.clear();
+    } else {
+        log.messages.erase(log.messages.begin(), log.messages.begin() + needed);
+        log.seqs.erase(log.seqs.begin(), log.seqs.begin() + needed);
+    }
 }
 
-// Atribui as mensagens em trânsito coletadas ao objeto `snapshot`, cria uma mensagem do tipo `SNAPSHOT_DATA` contendo o snapshot serializado, e a envia para o coordenador.
-void Philosopher::sendSnapshotToCoordinator() {
-    snapshot.channelMessages = messagesInTransit;
-    Message snap{ MessageType::SNAPSHOT_DATA, id, snapshot.serialize() };
-    sendMessage(COORDINATOR_PORT, snap.serialize());
+// Os registros dos canais não são tocados aqui, pois pertencem às threads de recepção: as mensagens da rodada descartada
+// são removidas no próximo marcador do canal ou na próxima mensagem recebida sem rodadas gravando o canal
+void Philosopher::dropRound(std::map<uint32_t, SnapshotRound>::iterator it) {
+    for (size_t i = 0; i < inputChannels.size(); ++i) {
+        if (!it->second.markersReceivedFrom.count(inputChannels[i])) --channelLogs[i].recording;
+    }
+    rounds.erase(it);
+}
+
+// Os canais de entrada são os de cada fragmento do coordenador e os de cada vizinho na topologia
+size_t Philosopher::expectedMarkers() const {
+    return neighbours.size() + config.coordinatorShards;
 }
 
-// Espera um ID de filósofo como argumento de linha de comando, cria uma instância da classe Philosopher com este ID e a inic
-int main(int argc, char* argv[]) {
-    if (argc < 2) {
-        std::cerr << "Uso: " << argv[0] << " <philosopher_id>\n";
-        return 1;
+// Cria uma mensagem do tipo "MARKER" da época e a envia para cada vizinho na topologia configurada.
+// No anel, cada rodada custa O(N) marcadores no total, em vez de O(N²) com todos os filósofos.
+void Philosopher::sendMarkerToOthers(uint32_t epoch) {
+    Message marker{ MessageType::MARKER, id };
+    marker.epoch = epoch;
+    for (int neighbour : neighbours) {
+        sendMessage(neighbour, marker);
     }
+}
 
-    int id = std::stoi(argv[1]);
-    Philosopher p(id);
-    p.start();
+// Cria uma mensagem do tipo `SNAPSHOT_DATA` da época contendo o snapshot serializado (estado local e mensagens em trânsito), e a envia para o coordenador.
+// Com "delta_snapshots", se o estado local é o mesmo do último snapshot enviado e não há mensagens em trânsito, a mensagem vai sem conteúdo
+// e o coordenador repete o último snapshot recebido deste filósofo. As mensagens ao coordenador chegam na ordem de envio, então não há confirmações.
+void Philosopher::sendSnapshotToCoordinator(uint32_t epoch, const Snapshot& snapshot) {
+    if (config.deltaSnapshots && snapshotSent && snapshot.channelMessages.empty() && snapshot.sameLocalState(lastSentSnapshot)) {
+        sendMessage(COORDINATOR_ID, Message{ MessageType::SNAPSHOT_DATA, id, -1, epoch });
+        return;
+    }
+    sendMessage(COORDINATOR_ID, Message{ MessageType::SNAPSHOT_DATA, id, -1, epoch, snapshot.serialize() });
+    if (!config.deltaSnapshots) return;
+    lastSentSnapshot.localState = snapshot.localState;
+    lastSentSnapshot.hasLeftFork = snapshot.hasLeftFork;
+    lastSentSnapshot.hasRightFork = snapshot.hasRightFork;
+    snapshotSent = true;
+}
+
+// Chamada com o lock "mtx" adquirido.
+// A agregação de uma rodada termina quando o snapshot local e os resumos de todos os filhos chegaram.
+// Antes de encaminhar, as esperas cujo dono do garfo está na subárvore viram arestas, e tudo o que envolve garfos usados
+// apenas dentro da subárvore é descartado, de forma que o resumo enviado ao pai cresce com a fronteira da subárvore
+void Philosopher::contributeToAggregation(uint32_t epoch, const PartialGraph& graph, bool local) {
+    if (epoch < oldestAcceptedEpoch) return;
+
+    Aggregation& aggregation = aggregations[epoch];
+    aggregation.graph.merge(graph);
+    if (local) aggregation.localDone = true;
+    else ++aggregation.childrenReported;
+
+    if (aggregation.localDone && aggregation.childrenReported == aggregationChildren.size()) {
+        aggregation.graph.resolve([this](int forkId) { return forkClosedInSubtree(forkId); });
+        Message summary{ MessageType::SNAPSHOT_SUMMARY, id, -1, epoch, aggregation.graph.serialize() };
+        sendMessage(aggregationParentId, std::move(summary));
+        aggregations.erase(epoch);
+        return;
+    }
 
-    return 0;
-}
\ No newline at end of file
+    if (aggregations.size() > static_cast<size_t>(config.maxInflightSnapshots)) {
+        LOG_WARN("[Filósofo " << id << "] Descartando agregação da rodada " << aggregations.begin()->first << " (muitas rodadas em andamento)");
+        aggregations.erase(aggregations.begin());
+    }
+}
+
+// O garfo 'f' é usado pelo filósofo 'f' (esquerdo) e pelo filósofo anterior no anel (direito)
+bool Philosopher::forkClosedInSubtree(int forkId) const {
+    int leftUser = forkId;
+    int rightUser = (forkId + config.numPhilosophers - 1) % config.numPhilosophers;
+    return config.inAggregationSubtree(id, leftUser) && config.inAggregationSubtree(id, rightUser);
+}
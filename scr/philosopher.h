@@ -2,10 +2,13 @@
 #define PHILOSOPHER_H
 
 #include <string>
+#include <algorithm>
+#include <cstdint>
 #include <mutex>
 #include <condition_variable>
 #include <map>
 #include <set>
+#include <unordered_map>
 #include <vector>
 #include <iostream>
 #include <thread>
@@ -19,61 +22,142 @@
 #include "message.h"
 #include "snapshot.h"
 #include "config.h"
-#include "snapshot.h"
+#include "connection.h"
+#include "transport.h"
+#include "executor.h"
+#include "async_transport.h"
+#include "partial_graph.h"
+#include "metrics.h"
 
 
 // Cada filósofo opera de forma autônoma, interagindo com um coordenador para solicitar e liberar garfos. 
 // Ele também participa do algoritmo de snapshot distribuído de Chandy-Lamport, registrando seu estado local e as mensagens em trânsito ao receber um marcador.
 class Philosopher {
 public:
-    // Construtor da classe Philosopher.
-    Philosopher(int id);
+    // Construtor da classe Philosopher, recebendo seu ID e a configuração do cluster.
+    // Sem "transport", as mensagens são enviadas por conexões TCP persistentes; o simulador passa o seu transporte em memória
+    Philosopher(int id, const Config& config, Transport* transport = nullptr);
     // Inicia o filósofo.
     // Cria e gerencia as threads para o loop de execução (comportamento de jantar) e o loop de escuta (receber mensagens).
     void start();
 
+    // Passos do ciclo de vida, dirigidos por eventos. São chamados pelo "runLoop" (com os tempos reais de pensar e comer)
+    // ou pelo simulador (com um relógio virtual)
+    // Termina de pensar: passa a ter fome e pede os dois garfos
+    void becomeHungry();
+    // Começa a comer se estiver com fome e já possuir os dois garfos. Retorna falso caso contrário
+    bool tryStartEating();
+    // Termina de comer: libera os dois garfos e volta a pensar
+    void finishEating();
+    // Despacha mensagens recebidas com base no tipo
+    void handleMessage(std::string_view data);
+
 private:
     int id;
+    // Configuração do cluster
+    Config config;
     int leftFork;
     int rightFork;
-    std::string state = "thinking";
+    PhilosopherState state = PhilosopherState::THINKING;
 
     bool hasLeft = false;
     bool hasRight = false;
 
-    // Flag se o filósofo está gravando mensagens em trânsito
-    bool recording = false;
-    // IDs dos filósofos (ou coordenador) de quem marcadores já foram recebidos
-    std::set<int> markersReceivedFrom;
-    // Mensagens em trâncsito
-    std::map<int, std::vector<std::string>> messagesInTransit;
-    // Objeto Snapshot para armazenar o estado local e mensagens em trânsito
-    Snapshot snapshot;
+    // Estado de uma rodada de snapshot em andamento
+    struct SnapshotRound {
+        // Objeto Snapshot para armazenar o estado local e mensagens em trânsito
+        Snapshot snapshot;
+        // IDs dos filósofos (ou coordenador) de quem marcadores já foram recebidos nesta rodada
+        std::set<int> markersReceivedFrom;
+        // Instante do primeiro marcador da rodada
+        std::chrono::steady_clock::time_point startedAt;
+        // Valor de "receiveSeq" quando o estado local foi salvo: as mensagens gravadas com número maior estão em trânsito na rodada
+        uint64_t startSeq = 0;
+    };
+    // Registro das mensagens recebidas por um canal de entrada enquanto alguma rodada o grava. Cada mensagem é acrescentada
+    // uma única vez, qualquer que seja o número de rodadas gravando o canal, com o número de recepção que a ordena em relação
+    // ao início das rodadas. "messages" e "seqs" só são acessados pela thread que recebe as mensagens do canal (a mesma que trata
+    // o seu marcador), sem o lock "mtx"; "recording" é protegido por "mtx"
+    struct ChannelLog {
+        std::vector<Message> messages;
+        std::vector<uint64_t> seqs;
+        // Número de rodadas que já começaram e ainda não receberam o marcador pelo canal
+        int recording = 0;
+    };
+    // Canais de entrada (vizinhos e fragmentos do coordenador), os seus registros e o índice de cada canal nos registros
+    std::vector<int> inputChannels;
+    std::vector<ChannelLog> channelLogs;
+    std::unordered_map<int, size_t> channelIndex;
+    // Número da última mensagem recebida cujo efeito foi aplicado, incrementado com o lock "mtx"
+    uint64_t receiveSeq = 0;
+    // Rodadas em andamento, indexadas pela época. Várias rodadas podem se sobrepor
+    std::map<uint32_t, SnapshotRound> rounds;
+    // Marcadores de épocas anteriores a esta são ignorados (rodadas descartadas)
+    uint32_t oldestAcceptedEpoch = 0;
+
+    // Estado local do último snapshot enviado ao coordenador, com "delta_snapshots" (sem as mensagens em trânsito)
+    Snapshot lastSentSnapshot;
+    bool snapshotSent = false;
+
+    // Agregação de uma rodada no modo de árvore: o resumo local e os resumos dos filhos recebidos até agora
+    struct Aggregation {
+        PartialGraph graph;
+        size_t childrenReported = 0;
+        bool localDone = false;
+    };
+    // Agregações em andamento, indexadas pela época
+    std::map<uint32_t, Aggregation> aggregations;
+    // Filhos deste filósofo na árvore de agregação e o ID do pai (outro filósofo ou COORDINATOR_ID)
+    std::vector<int> aggregationChildren;
+    int aggregationParentId = COORDINATOR_ID;
 
     std::mutex mtx;
     // Variável de condição para sincronizar a espera pelos garfos
     std::condition_variable cv;
-     //Flag para indicar que um snapshot está sendo coletado
-    bool collectingSnapshot = false;
+    // Conexões persistentes com o coordenador e com os outros filósofos
+    ConnectionPool connections;
+    // Com "send_threads" maior que 0, os envios são enfileirados por destino e feitos pelas threads do executor,
+    // para que o tratamento das mensagens (com o lock "mtx") nunca espere pela rede
+    std::unique_ptr<AsyncTransport> outbox;
+    // Declarado depois da fila, para que as threads terminem antes de ela ser destruída
+    std::unique_ptr<Executor> executor;
+    // Meio usado para enviar as mensagens: a fila assíncrona, as conexões acima ou o transporte recebido no construtor
+    Transport* transport;
+    // Filósofos vizinhos na topologia configurada: os canais de entrada e saída dos marcadores, além do coordenador
+    std::vector<int> neighbours;
 
     // Loop principal do comportamento do filósofo
     void runLoop();
+    // Mesma verificação de "tryStartEating", chamada com o lock "mtx" adquirido
+    bool startEatingLocked();
     // Loop de escuta por mensagens de rede
     void listenLoop();
     // Solicitaçao de um garfo ao coordenador
     void requestFork(int forkId);
     // Liberação de um garfo para o coordenador
     void releaseFork(int forkId);
-    // Envio de mensagens
-    void sendMessage(int port, const std::string& data);
-    // Despacha mensagens recebidas com base no tipo
-    void handleMessage(const std::string& data);
-    // Lida com a recepção de uma mensagem de marcador
-    void handleMarker(int fromId);
-    // Envia marcadores para os outros filósofos
-    void sendMarkerToOthers();
-    // Envia o snapshot coletado para o coordenador
-    void sendSnapshotToCoordinator();
+    // Modo "acquire_mode=pair": solicitação e liberação dos dois garfos em uma única mensagem
+    void requestPair();
+    void releasePair();
+    // Envio de mensagens ao filósofo ou ao fragmento do coordenador (coordinatorId) especificado
+    void sendMessage(int targetId, Message msg);
+    // Lida com a recepção de uma mensagem de marcador da rodada "epoch"
+    void handleMarker(int fromId, uint32_t epoch);
+    // Número de canais de entrada, ou seja, de marcadores esperados em cada rodada
+    size_t expectedMarkers() const;
+    // Registra o marcador da rodada recebido pelo canal, encerrando a gravação do canal pela rodada
+    // e entregando ao snapshot as mensagens gravadas no registro do canal
+    void closeChannel(SnapshotRound& round, int fromId);
+    // Descarta uma rodada incompleta, encerrando a gravação dos canais ainda abertos
+    void dropRound(std::map<uint32_t, SnapshotRound>::iterator it);
+    // Envia marcadores da rodada para os filósofos vizinhos
+    void sendMarkerToOthers(uint32_t epoch);
+    // Envia o snapshot coletado na rodada para o coordenador
+    void sendSnapshotToCoordinator(uint32_t epoch, const Snapshot& snapshot);
+    // Junta um resumo (local ou de um filho) à agregação da rodada e, quando a subárvore estiver completa, o encaminha ao pai
+    void contributeToAggregation(uint32_t epoch, const PartialGraph& graph, bool local);
+    // Verifica se todos os filósofos que usam o garfo estão na subárvore deste filósofo
+    bool forkClosedInSubtree(int forkId) const;
 };
 
 #endif
\ No newline at end of file
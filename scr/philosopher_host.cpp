@@ -0,0 +1,96 @@
+#include "philosopher_host.h"
+
+#include <algorithm>
+#include <random>
+#include <thread>
+
+#include "log.h"
+#include "metrics.h"
+
+// Os filósofos hospedados recebem o transporte compartilhado e não criam threads de envio próprias
+PhilosopherHost::PhilosopherHost(int firstId, const Config& config, Transport* transport)
+    : firstId(firstId), config(config), connections("Processo " + std::to_string(firstId), config.host),
+      transport(transport ? transport : &connections) {
+    if (config.sendThreads > 0) {
+        executor = std::make_unique<Executor>("Processo " + std::to_string(firstId), config.sendThreads);
+        outbox = std::make_unique<AsyncTransport>("Processo " + std::to_string(firstId), *this->transport, *executor);
+        this->transport = outbox.get();
+    }
+    Config hosted = config;
+    hosted.sendThreads = 0;
+    int lastId = std::min(firstId + config.philosophersPerProcess, config.numPhilosophers);
+    for (int id = firstId; id < lastId; ++id) philosophers.push_back(std::make_unique<Philosopher>(id, hosted, this->transport));
+    hungrySince.resize(philosophers.size());
+    LOG_INFO("[Processo " << firstId << "] Hospedando os filósofos " << firstId << " a " << lastId - 1);
+}
+
+// Os primeiros prazos são sorteados dentro do tempo de pensar, para que os filósofos do grupo não fiquem com fome todos ao mesmo tempo.
+// Espalhá-los em ordem faria cada filósofo pegar o garfo do seguinte logo antes dele, formando uma cadeia de espera pelo anel
+// que se repetiria a cada ciclo
+void PhilosopherHost::start() {
+    std::mt19937 rng(firstId);
+    std::uniform_int_distribution<int> offset(0, std::max(config.thinkMs - 1, 0));
+    for (size_t i = 0; i < philosophers.size(); ++i) schedule(static_cast<int>(i), std::chrono::milliseconds(offset(rng)), false);
+    std::thread listener(&PhilosopherHost::listenLoop, this);
+    timerLoop();
+    listener.join();
+}
+
+void PhilosopherHost::listenLoop() {
+    int port = config.philosopherPort(firstId);
+    LOG_INFO("[Processo " << firstId << "] Aguardando mensagens na porta " << port << "...");
+    if (!transport->listen(port, [this](std::string_view data) { route(data); })) {
+        LOG_ERROR("[Processo " << firstId << "] Não foi possível escutar na porta " << port);
+    }
+}
+
+// Pode ser chamada por várias threads de recepção ao mesmo tempo: cada filósofo protege o próprio estado
+void PhilosopherHost::route(std::string_view data) {
+    int32_t targetId;
+    if (!Message::peekTarget(data, targetId) || targetId < firstId || targetId - firstId >= static_cast<int32_t>(philosophers.size())) {
+        LOG_WARN("[Processo " << firstId << "] Mensagem para um filósofo que não está neste processo. Ignorando.");
+        return;
+    }
+    int index = targetId - firstId;
+    Philosopher& philosopher = *philosophers[index];
+    philosopher.handleMessage(data);
+    if (philosopher.tryStartEating()) {
+        record(Histogram::FORK_ACQUIRE_NS, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - hungrySince[index]).count());
+        schedule(index, std::chrono::milliseconds(config.eatMs), true);
+    }
+}
+
+void PhilosopherHost::schedule(int index, std::chrono::milliseconds delay, bool eating) {
+    {
+        std::lock_guard<std::mutex> lock(deadlinesMtx);
+        deadlines.push_back(Deadline{ std::chrono::steady_clock::now() + delay, index, eating });
+        std::push_heap(deadlines.begin(), deadlines.end(), laterThan);
+    }
+    deadlinesCv.notify_one();
+}
+
+// Os passos dos filósofos são executados sem o lock do heap, já que podem agendar novos prazos e enviar mensagens
+void PhilosopherHost::timerLoop() {
+    while (true) {
+        Deadline due;
+        {
+            std::unique_lock<std::mutex> lock(deadlinesMtx);
+            while (deadlines.empty() || deadlines.front().at > std::chrono::steady_clock::now()) {
+                if (deadlines.empty()) deadlinesCv.wait(lock);
+                else deadlinesCv.wait_until(lock, deadlines.front().at);
+            }
+            std::pop_heap(deadlines.begin(), deadlines.end(), laterThan);
+            due = deadlines.back();
+            deadlines.pop_back();
+        }
+
+        Philosopher& philosopher = *philosophers[due.index];
+        if (due.eating) {
+            philosopher.finishEating();
+            schedule(due.index, std::chrono::milliseconds(config.thinkMs), false);
+        } else {
+            hungrySince[due.index] = std::chrono::steady_clock::now();
+            philosopher.becomeHungry();
+        }
+    }
+}
@@ -0,0 +1,71 @@
+#ifndef PHILOSOPHER_HOST_H
+#define PHILOSOPHER_HOST_H
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <string_view>
+
+#include "config.h"
+#include "connection.h"
+#include "transport.h"
+#include "executor.h"
+#include "async_transport.h"
+#include "philosopher.h"
+
+
+// Hospeda vários filósofos em um único processo (configuração "philosophers_per_process").
+// Em vez de duas threads e uma porta por filósofo, todos compartilham:
+//  - uma única porta de escuta (a do primeiro filósofo do grupo), com as mensagens entregues pelo ID do destinatário;
+//  - um único transporte de saída, com uma conexão por processo de destino em vez de uma por filósofo;
+//  - um único laço de tempos, que dirige os passos de cada filósofo (fim de pensar e de comer) por um heap de prazos.
+// Cada filósofo continua com o seu próprio estado e lock, então as mensagens de filósofos diferentes são tratadas em paralelo.
+class PhilosopherHost {
+public:
+    // Hospeda os filósofos "firstId" a "firstId + philosophers_per_process - 1" (limitado ao número de filósofos).
+    // "transport" funciona como no Philosopher: sem ele, as mensagens vão por conexões TCP persistentes
+    PhilosopherHost(int firstId, const Config& config, Transport* transport = nullptr);
+    // Inicia a escuta em uma thread e executa o laço de tempos na thread atual. Não retorna
+    void start();
+
+private:
+    // Prazo de um filósofo no laço de tempos
+    struct Deadline {
+        std::chrono::steady_clock::time_point at;
+        // Índice do filósofo no grupo
+        int index;
+        // Fim da refeição (verdadeiro) ou do tempo de pensar (falso)
+        bool eating;
+    };
+
+    int firstId;
+    Config config;
+    ConnectionPool connections;
+    // Mesma ordem de declaração do Philosopher: as threads de envio terminam antes de a fila ser destruída
+    std::unique_ptr<AsyncTransport> outbox;
+    std::unique_ptr<Executor> executor;
+    Transport* transport;
+    std::vector<std::unique_ptr<Philosopher>> philosophers;
+    // Instante em que cada filósofo começou a esperar pelos garfos
+    std::vector<std::chrono::steady_clock::time_point> hungrySince;
+
+    // Heap de prazos, com o mais próximo na frente
+    std::mutex deadlinesMtx;
+    std::condition_variable deadlinesCv;
+    std::vector<Deadline> deadlines;
+
+    static bool laterThan(const Deadline& a, const Deadline& b) { return a.at > b.at; }
+
+    // Escuta na porta do grupo e entrega cada mensagem ao filósofo destinatário
+    void listenLoop();
+    // Entrega a mensagem ao filósofo e, se ele estava com fome e agora tem os dois garfos, agenda o fim da refeição
+    void route(std::string_view data);
+    // Laço de tempos: espera o próximo prazo e executa o passo correspondente do filósofo
+    void timerLoop();
+    // Agenda um prazo para o filósofo
+    void schedule(int index, std::chrono::milliseconds delay, bool eating);
+};
+
+#endif
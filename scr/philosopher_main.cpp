@@ -0,0 +1,41 @@
+#include "philosopher.h"
+#include "philosopher_host.h"
+#include "shm_transport.h"
+
+// Espera um ID de filósofo como argumento de linha de comando (além das opções de configuração), cria uma instância da classe Philosopher com este ID e a inic.
+// Com "philosophers_per_process" maior que 1, o ID deve ser o primeiro de um grupo, e o processo hospeda o grupo inteiro
+int main(int argc, char* argv[]) {
+    Config config;
+    std::vector<std::string> positional;
+    if (!Config::load(argc, argv, config, positional) || positional.size() != 1) {
+        std::cerr << "Uso: " << argv[0] << " <philosopher_id> [--config=arquivo] [--chave=valor ...]\n";
+        return 1;
+    }
+
+    int id = std::atoi(positional[0].c_str());
+    if (id < 0 || id >= config.numPhilosophers) {
+        std::cerr << "ID de filósofo inválido: " << positional[0] << " (esperado 0 a " << config.numPhilosophers - 1 << ")\n";
+        return 1;
+    }
+    if (id % config.philosophersPerProcess != 0) {
+        std::cerr << "Com philosophers_per_process=" << config.philosophersPerProcess << " o ID deve ser múltiplo de " << config.philosophersPerProcess << "\n";
+        return 1;
+    }
+    setLogLevel(config.logLevel);
+    startMetricsExporter(config.philosophersPerProcess > 1 ? "Processo " + std::to_string(id) : "Filósofo " + std::to_string(id), config.host, config.metricsPort > 0 ? config.metricsPort + 1 + id : 0);
+    // Uma conexão de saída e uma de entrada para cada outro filósofo
+    raiseFileDescriptorLimit(2 * config.numPhilosophers + 64);
+
+    // Com "transport=shm" as mensagens vão pela memória compartilhada; caso contrário, pelas conexões TCP do próprio filósofo
+    std::unique_ptr<Transport> transport;
+    if (config.transport == TransportKind::SHM) transport = std::make_unique<ShmTransport>(config, config.philosopherPort(id));
+    if (config.philosophersPerProcess > 1) {
+        PhilosopherHost host(id, config, transport.get());
+        host.start();
+        return 0;
+    }
+    Philosopher p(id, config, transport.get());
+    p.start();
+
+    return 0;
+}
\ No newline at end of file
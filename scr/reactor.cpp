@@ -0,0 +1,373 @@
+#include "reactor.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <iostream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "log.h"
+
+// Quantidade máxima de eventos tratados por chamada de "epoll_wait"
+static const int MAX_EVENTS = 256;
+
+Reactor::Reactor(const std::string& owner, const std::string& host) : owner(owner), host(host) {
+    epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd < 0) perror("epoll_create1 failed");
+
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeFd < 0) perror("eventfd failed");
+
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLET;
+    ev.data.ptr = &wakeFd;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, wakeFd, &ev);
+}
+
+Reactor::~Reactor() {
+    for (auto& [fd, conn] : connections) close(fd);
+    if (wakeFd >= 0) close(wakeFd);
+    if (epfd >= 0) close(epfd);
+}
+
+void Reactor::setHandler(FrameHandler handler) {
+    this->handler = std::move(handler);
+}
+
+void Reactor::setPortHandler(PortFrameHandler handler) {
+    portHandler = std::move(handler);
+}
+
+// Abre um socket não bloqueante, vincula ele à porta e o registra no epoll para aceitar conexões.
+// O socket de escuta é guardado junto com as conexões, marcado como "listening"
+bool Reactor::listenOn(int port, bool reusePort) {
+    int listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd < 0) {
+        perror("socket creation failed");
+        return false;
+    }
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    // Aceita conexões de qualquer endereço
+    addr.sin_addr.s_addr = INADDR_ANY;
+
+    int enable = 1;
+    if (setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(int)) < 0) {
+        perror("setsockopt failed");
+    }
+    if (reusePort && setsockopt(listenFd, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(int)) < 0) {
+        perror("setsockopt(SO_REUSEPORT) failed");
+    }
+    if (bind(listenFd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+        perror("bind failed");
+        close(listenFd);
+        return false;
+    }
+    if (::listen(listenFd, SOMAXCONN) < 0) {
+        perror("listen failed");
+        close(listenFd);
+        return false;
+    }
+
+    auto listener = std::make_unique<Connection>();
+    listener->fd = listenFd;
+    listener->listening = true;
+    listener->localPort = port;
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLET;
+    ev.data.ptr = listener.get();
+    epoll_ctl(epfd, EPOLL_CTL_ADD, listenFd, &ev);
+    connections[listenFd] = std::move(listener);
+    return true;
+}
+
+// Na thread do laço a mensagem vai direto para a fila da conexão.
+// Nas demais threads ela é guardada em "pendingSends" e o laço é acordado pelo eventfd.
+void Reactor::sendTo(int port, std::string_view data) {
+    if (std::this_thread::get_id() == loopThread) {
+        enqueue(port, data);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(pendingMtx);
+        pendingSends.emplace_back(port, std::string(data));
+    }
+    uint64_t one = 1;
+    if (write(wakeFd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+        perror("eventfd write failed");
+    }
+}
+
+bool Reactor::send(int port, std::string_view data) {
+    sendTo(port, data);
+    return true;
+}
+
+bool Reactor::listen(int port, const MessageHandler& handler) {
+    setHandler(handler);
+    if (!listenOn(port, true)) return false;
+    run();
+    return true;
+}
+
+// Espera por eventos e os trata: novas conexões, dados recebidos, sockets prontos para escrita e mensagens de outras threads
+void Reactor::run() {
+    loopThread = std::this_thread::get_id();
+    epoll_event events[MAX_EVENTS];
+
+    while (true) {
+        int n = epoll_wait(epfd, events, MAX_EVENTS, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait failed");
+            return;
+        }
+
+        for (int i = 0; i < n; ++i) {
+            void* ptr = events[i].data.ptr;
+            if (ptr == &wakeFd) {
+                uint64_t count;
+                while (read(wakeFd, &count, sizeof(count)) > 0) {}
+                drainPending();
+                continue;
+            }
+
+            Connection& conn = *static_cast<Connection*>(ptr);
+            if (conn.closed) continue;
+            if (conn.listening) {
+                acceptAll(conn);
+                continue;
+            }
+
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                if (!(events[i].events & EPOLLIN)) {
+                    closeConnection(conn);
+                    continue;
+                }
+            }
+            if (events[i].events & EPOLLOUT) {
+                if (conn.connecting) {
+                    int error = 0;
+                    socklen_t len = sizeof(error);
+                    getsockopt(conn.fd, SOL_SOCKET, SO_ERROR, &error, &len);
+                    if (error != 0) {
+                        closeConnection(conn);
+                        continue;
+                    }
+                    conn.connecting = false;
+                }
+                flush(conn);
+            }
+            if (!conn.closed && (events[i].events & EPOLLIN)) {
+                readAll(conn);
+            }
+        }
+        graveyard.clear();
+    }
+}
+
+// Como o socket de escuta é edge-triggered, aceita conexões até que não haja mais nenhuma pendente
+void Reactor::acceptAll(const Connection& listener) {
+    while (true) {
+        int client = accept4(listener.fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (client < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) perror("accept failed");
+            return;
+        }
+        int enable = 1;
+        setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+
+        auto conn = std::make_unique<Connection>();
+        conn->fd = client;
+        conn->localPort = listener.localPort;
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        ev.data.ptr = conn.get();
+        epoll_ctl(epfd, EPOLL_CTL_ADD, client, &ev);
+        connections[client] = std::move(conn);
+    }
+}
+
+// Lê até o socket não ter mais dados, entregando ao handler cada mensagem completa.
+// As mensagens são entregues antes da próxima leitura, pois apontam para o buffer de recepção.
+void Reactor::readAll(Connection& conn) {
+    while (true) {
+        ssize_t valread = conn.reader.fill(conn.fd);
+        if (valread < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) closeConnection(conn);
+            return;
+        }
+        if (valread == 0) {
+            closeConnection(conn);
+            return;
+        }
+
+        std::string_view payload;
+        while (!conn.closed && conn.reader.next(payload)) {
+            if (portHandler) portHandler(conn.localPort, payload);
+            else if (handler) handler(payload);
+        }
+        if (conn.closed) return;
+        if (conn.reader.corrupted()) {
+            LOG_WARN("[" << owner << "] Mensagem com cabeçalho inválido recebida. Encerrando conexão.");
+            closeConnection(conn);
+            return;
+        }
+    }
+}
+
+// Escreve a fila de saída até esvaziá-la ou até o socket não aceitar mais dados.
+// O restante é escrito quando o epoll indicar que o socket está novamente pronto para escrita.
+void Reactor::flush(Connection& conn) {
+    if (conn.connecting || conn.closed) return;
+
+    while (conn.outOffset < conn.outbound.size()) {
+        ssize_t sent = ::send(conn.fd, conn.outbound.data() + conn.outOffset, conn.outbound.size() - conn.outOffset, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            closeConnection(conn);
+            return;
+        }
+        conn.outOffset += sent;
+    }
+
+    // Registra a latência (do enfileiramento até a escrita no socket) das mensagens escritas por completo
+    if (!conn.pendingFrames.empty() && conn.pendingFrames.front().first <= conn.outOffset) {
+        auto now = Clock::now();
+        std::lock_guard<std::mutex> lock(statsMtx);
+        PeerStats& peer = stats[conn.port];
+        while (!conn.pendingFrames.empty() && conn.pendingFrames.front().first <= conn.outOffset) {
+            uint64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(now - conn.pendingFrames.front().second).count();
+            peer.sends++;
+            peer.totalNs += elapsed;
+            if (elapsed > peer.maxNs) peer.maxNs = elapsed;
+            conn.pendingFrames.pop_front();
+        }
+    }
+
+    // Fila vazia: reaproveita o buffer para as próximas mensagens
+    if (conn.outOffset == conn.outbound.size()) {
+        conn.outbound.clear();
+        conn.outOffset = 0;
+    }
+}
+
+void Reactor::enqueue(int port, std::string_view data) {
+    auto it = outboundByPort.find(port);
+    Connection* conn = it != outboundByPort.end() ? it->second : openOutbound(port);
+    if (!conn) {
+        std::lock_guard<std::mutex> lock(statsMtx);
+        stats[port].failures++;
+        return;
+    }
+
+    appendFrame(conn->outbound, data);
+    conn->pendingFrames.emplace_back(conn->outbound.size(), Clock::now());
+    flush(*conn);
+}
+
+void Reactor::drainPending() {
+    std::vector<std::pair<int, std::string>> batch;
+    {
+        std::lock_guard<std::mutex> lock(pendingMtx);
+        batch.swap(pendingSends);
+    }
+    for (const auto& [port, data] : batch) {
+        enqueue(port, data);
+    }
+}
+
+// Inicia um "connect" não bloqueante. A conexão só é usada para escrita depois que o epoll indicar que ela foi estabelecida
+Reactor::Connection* Reactor::openOutbound(int port) {
+    int sock = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (sock < 0) {
+        perror("socket creation failed");
+        return nullptr;
+    }
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, host.c_str(), &addr.sin_addr) <= 0) {
+        perror("Invalid address/ Address not supported");
+        close(sock);
+        return nullptr;
+    }
+    int enable = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+
+    auto conn = std::make_unique<Connection>();
+    conn->fd = sock;
+    conn->port = port;
+    if (connect(sock, (sockaddr*)&addr, sizeof(addr)) < 0) {
+        if (errno != EINPROGRESS) {
+            close(sock);
+            return nullptr;
+        }
+        conn->connecting = true;
+    }
+
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    ev.data.ptr = conn.get();
+    epoll_ctl(epfd, EPOLL_CTL_ADD, sock, &ev);
+
+    {
+        std::lock_guard<std::mutex> lock(statsMtx);
+        PeerStats& peer = stats[port];
+        if (peer.sends > 0 || peer.failures > 0) peer.reconnects++;
+    }
+
+    Connection* raw = conn.get();
+    outboundByPort[port] = raw;
+    connections[sock] = std::move(conn);
+    return raw;
+}
+
+// As mensagens que ainda estavam na fila de saída são descartadas e contadas como falhas.
+// O próximo envio para a mesma porta abre uma nova conexão.
+void Reactor::closeConnection(Connection& conn) {
+    if (conn.closed) return;
+    conn.closed = true;
+    epoll_ctl(epfd, EPOLL_CTL_DEL, conn.fd, nullptr);
+    close(conn.fd);
+
+    if (conn.port >= 0) {
+        if (!conn.pendingFrames.empty()) {
+            std::lock_guard<std::mutex> lock(statsMtx);
+            stats[conn.port].failures += conn.pendingFrames.size();
+        }
+        auto it = outboundByPort.find(conn.port);
+        if (it != outboundByPort.end() && it->second == &conn) outboundByPort.erase(it);
+    }
+
+    auto it = connections.find(conn.fd);
+    if (it != connections.end()) {
+        graveyard.push_back(std::move(it->second));
+        connections.erase(it);
+    }
+}
+
+// Imprime, para cada destino, a quantidade de envios, as latências média e máxima (em microssegundos),
+// as reconexões e as falhas.
+void Reactor::printStats(std::ostream& out) {
+    std::lock_guard<std::mutex> lock(statsMtx);
+    for (const auto& [port, peer] : stats) {
+        double avgUs = peer.sends ? (peer.totalNs / 1000.0) / peer.sends : 0.0;
+        out << "[" << owner << "] Conexão porta " << port
+            << ": envios=" << peer.sends
+            << ", latência média=" << avgUs << "us"
+            << ", máxima=" << peer.maxNs / 1000.0 << "us"
+            << ", reconexões=" << peer.reconnects
+            << ", falhas=" << peer.failures << "\n";
+    }
+    out << std::flush;
+}
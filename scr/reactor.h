@@ -0,0 +1,133 @@
+#ifndef REACTOR_H
+#define REACTOR_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <map>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <functional>
+#include <ostream>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "frame.h"
+#include "transport.h"
+
+
+// Laço de eventos baseado em epoll (edge-triggered) com sockets não bloqueantes.
+// Uma única thread aceita conexões, lê as mensagens enquadradas de todas elas e escreve as filas de saída,
+// de forma que um filósofo lento não atrasa o atendimento dos demais.
+// As mensagens enviadas são colocadas na fila de saída da conexão com o destino e escritas quando o socket permitir.
+class Reactor : public Transport {
+public:
+    // Função chamada para cada mensagem recebida. A "string_view" só é válida durante a chamada
+    using FrameHandler = std::function<void(std::string_view)>;
+    // Variante que também recebe a porta de escuta pela qual a conexão foi aceita (útil quando o laço escuta em várias portas)
+    using PortFrameHandler = std::function<void(int localPort, std::string_view)>;
+
+    // Construtor da classe. "owner" é usado apenas para identificar o dono nas mensagens impressas
+    // e "host" é o endereço usado para as conexões de saída
+    Reactor(const std::string& owner, const std::string& host);
+    // Fecha todas as conexões e os descritores do epoll
+    ~Reactor();
+
+    // Define a função que tratará as mensagens recebidas
+    void setHandler(FrameHandler handler);
+    // Define a função que tratará as mensagens recebidas, identificando a porta local. Tem precedência sobre "setHandler"
+    void setPortHandler(PortFrameHandler handler);
+    // Abre um socket de escuta na porta especificada. Retorna falso em caso de erro.
+    // Pode ser chamada várias vezes para escutar em várias portas no mesmo laço.
+    // Com "reusePort", vários Reactors (um por thread) podem escutar a mesma porta e o kernel distribui as conexões entre eles
+    bool listenOn(int port, bool reusePort = false);
+    // Coloca a mensagem na fila de saída da conexão com a porta especificada, criando a conexão se necessário.
+    // Pode ser chamada de qualquer thread e nunca bloqueia na rede.
+    void sendTo(int port, std::string_view data);
+    // Executa o laço de eventos na thread atual. Não retorna
+    void run();
+
+    // Transport: "send" é o mesmo que "sendTo" (o envio nunca falha de imediato, só é enfileirado).
+    // "listen" define o handler, escuta na porta com SO_REUSEPORT (para que cada thread de E/S possa ter seu próprio laço)
+    // e executa o laço de eventos
+    bool send(int port, std::string_view data) override;
+    bool listen(int port, const MessageHandler& handler) override;
+    // Imprime as estatísticas de envio de cada destino
+    void printStats(std::ostream& out);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // Estado de uma conexão (aceita ou criada para envio)
+    struct Connection {
+        int fd = -1;
+        // Porta de destino para conexões de saída, -1 para conexões aceitas
+        int port = -1;
+        // Socket de escuta: os eventos indicam conexões a aceitar
+        bool listening = false;
+        // Porta de escuta (para o socket de escuta e as conexões aceitas por ele), -1 para conexões de saída
+        int localPort = -1;
+        // Conexão de saída aguardando o término do "connect"
+        bool connecting = false;
+        bool closed = false;
+        FrameReader reader;
+        // Fila de saída: mensagens enquadradas ainda não escritas no socket
+        std::string outbound;
+        size_t outOffset = 0;
+        // Posição final (em "outbound") e instante de enfileiramento de cada mensagem ainda não escrita
+        std::deque<std::pair<size_t, Clock::time_point>> pendingFrames;
+    };
+
+    // Estatísticas de envio por destino, preservadas entre reconexões
+    struct PeerStats {
+        uint64_t sends = 0;
+        uint64_t failures = 0;
+        uint64_t reconnects = 0;
+        uint64_t totalNs = 0;
+        uint64_t maxNs = 0;
+    };
+
+    std::string owner;
+    std::string host;
+    FrameHandler handler;
+    PortFrameHandler portHandler;
+    int epfd = -1;
+    // eventfd usado para acordar o laço quando outra thread enfileira mensagens
+    int wakeFd = -1;
+    // Thread que executa o laço de eventos
+    std::atomic<std::thread::id> loopThread;
+
+    std::unordered_map<int, std::unique_ptr<Connection>> connections;
+    std::unordered_map<int, Connection*> outboundByPort;
+    // Conexões fechadas durante o processamento de um lote de eventos, liberadas ao final do lote
+    std::vector<std::unique_ptr<Connection>> graveyard;
+
+    // Mensagens enfileiradas por outras threads, aguardando o laço de eventos
+    std::mutex pendingMtx;
+    std::vector<std::pair<int, std::string>> pendingSends;
+
+    // Protege as estatísticas, lidas por outras threads
+    std::mutex statsMtx;
+    std::map<int, PeerStats> stats;
+
+    // Aceita todas as conexões pendentes no socket de escuta
+    void acceptAll(const Connection& listener);
+    // Lê e despacha todas as mensagens disponíveis na conexão
+    void readAll(Connection& conn);
+    // Escreve o máximo possível da fila de saída da conexão
+    void flush(Connection& conn);
+    // Enfileira a mensagem na conexão de saída com a porta, criando-a se necessário (apenas na thread do laço)
+    void enqueue(int port, std::string_view data);
+    // Processa as mensagens enfileiradas por outras threads
+    void drainPending();
+    // Cria uma conexão de saída não bloqueante com a porta especificada
+    Connection* openOutbound(int port);
+    // Remove a conexão do epoll e a fecha. A memória é liberada ao final do lote de eventos
+    void closeConnection(Connection& conn);
+};
+
+#endif
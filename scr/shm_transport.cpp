@@ -0,0 +1,321 @@
+#include "shm_transport.h"
+
+#include <chrono>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "log.h"
+
+namespace {
+
+const uint32_t SHM_MAGIC = 0x44505348;
+const uint32_t SHM_VERSION = 1;
+// Marca no lugar do tamanho de um registro: o restante do buffer até o fim está vazio e o próximo registro começa no início.
+// Assim cada mensagem fica contígua e pode ser entregue sem cópia
+const uint32_t WRAP_MARKER = 0xFFFFFFFF;
+// Marca no lugar do tamanho de um registro: os fragmentos já escritos da mensagem incompleta do remetente devem ser descartados
+const uint32_t ABORT_MARKER = 0xFFFFFFFE;
+// Bit do tamanho que indica um fragmento de mensagem, a ser concatenado com os registros seguintes até o último (sem o bit)
+const uint32_t FRAGMENT_FLAG = 0x80000000;
+// Os registros (tamanho de 4 bytes + conteúdo) começam em posições múltiplas de 8
+const size_t RECORD_ALIGN = 8;
+const size_t CACHE_LINE = 64;
+// Varreduras sem mensagens antes de a thread de escuta dormir no futex
+const int IDLE_SPINS = 2000;
+// Tempo máximo que um remetente espera por espaço em um buffer cheio
+const auto FULL_TIMEOUT = std::chrono::seconds(1);
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free,
+              "as operações atômicas na memória compartilhada precisam ser livres de lock");
+
+inline size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+// Posições de escrita (do produtor) e de leitura (do consumidor) de um buffer, em linhas de cache separadas.
+// As posições só crescem; o deslocamento no buffer é a posição módulo o tamanho
+struct RingHeader {
+    alignas(CACHE_LINE) std::atomic<uint64_t> tail;
+    alignas(CACHE_LINE) std::atomic<uint64_t> head;
+};
+
+void futexWait(std::atomic<uint32_t>* word, uint32_t expected, long timeoutNs) {
+    timespec timeout{ 0, timeoutNs };
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT, expected, &timeout, nullptr, 0);
+}
+
+void futexWake(std::atomic<uint32_t>* word) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+}
+
+std::string segmentName(int port) {
+    return "/dphil-" + std::to_string(port);
+}
+
+} // namespace
+
+// Cabeçalho do segmento de um destino. Em seguida vêm o mapa de buffers em uso (um bit por remetente)
+// e os buffers, cada um com o seu RingHeader
+struct ShmTransport::Segment {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slots;
+    uint32_t ringBytes;
+    // Publicado pelo destino depois de inicializar o segmento
+    std::atomic<uint32_t> ready;
+    // Palavra do futex: incrementada a cada mensagem publicada
+    alignas(CACHE_LINE) std::atomic<uint32_t> doorbell;
+    // Indica que a thread de escuta pode estar dormindo no futex
+    std::atomic<uint32_t> sleeping;
+
+    size_t activeOffset() const { return alignUp(sizeof(Segment), CACHE_LINE); }
+    size_t ringsOffset() const { return activeOffset() + alignUp(activeWords() * sizeof(uint64_t), CACHE_LINE); }
+    size_t ringStride() const { return sizeof(RingHeader) + ringBytes; }
+    uint32_t activeWords() const { return (slots + 63) / 64; }
+
+    std::atomic<uint64_t>* active() {
+        return reinterpret_cast<std::atomic<uint64_t>*>(reinterpret_cast<char*>(this) + activeOffset());
+    }
+    RingHeader& ring(uint32_t slot) {
+        return *reinterpret_cast<RingHeader*>(reinterpret_cast<char*>(this) + ringsOffset() + slot * ringStride());
+    }
+    char* ringData(uint32_t slot) {
+        return reinterpret_cast<char*>(&ring(slot)) + sizeof(RingHeader);
+    }
+};
+
+ShmTransport::ShmTransport(const Config& config, int ownPort) : config(config), slot(slotOf(ownPort)) {}
+
+ShmTransport::~ShmTransport() {
+    for (auto& [port, peer] : peers) {
+        if (peer->segment) munmap(peer->segment, peer->size);
+    }
+}
+
+uint32_t ShmTransport::slotOf(int port) const {
+    if (port >= config.coordinatorPort && port < config.coordinatorPort + config.coordinatorShards)
+        return config.numPhilosophers + (port - config.coordinatorPort);
+    return static_cast<uint32_t>(port - config.basePort);
+}
+
+uint32_t ShmTransport::slotCount() const {
+    return config.numPhilosophers + config.coordinatorShards;
+}
+
+// O segmento é criado com "ftruncate", então as páginas dos buffers que nunca forem usados não ocupam memória
+size_t ShmTransport::segmentSize() const {
+    Segment layout{};
+    layout.slots = slotCount();
+    layout.ringBytes = static_cast<uint32_t>(config.shmRingKb) * 1024;
+    return layout.ringsOffset() + layout.slots * layout.ringStride();
+}
+
+// Um segmento inexistente ou ainda não inicializado não é um erro: o destino pode não ter iniciado ainda, e o envio é tentado de novo depois
+ShmTransport::Segment* ShmTransport::attach(int port, size_t& size) {
+    int fd = shm_open(segmentName(port).c_str(), O_RDWR, 0600);
+    if (fd < 0) return nullptr;
+    size = segmentSize();
+    struct stat st{};
+    if (fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < size) {
+        close(fd);
+        return nullptr;
+    }
+    void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        perror("mmap failed");
+        return nullptr;
+    }
+    Segment* segment = static_cast<Segment*>(memory);
+    if (!segment->ready.load(std::memory_order_acquire) || segment->magic != SHM_MAGIC || segment->version != SHM_VERSION ||
+        segment->slots != slotCount() || segment->ringBytes != static_cast<uint32_t>(config.shmRingKb) * 1024) {
+        munmap(memory, size);
+        return nullptr;
+    }
+    segment->active()[slot / 64].fetch_or(uint64_t(1) << (slot % 64), std::memory_order_release);
+    return segment;
+}
+
+// Chamada com o lock do destino adquirido.
+// Se o registro não couber até o fim do buffer, o espaço restante é marcado com WRAP_MARKER e o registro começa no início.
+// Depois de publicar a nova posição de escrita, toca o "doorbell" e só faz a chamada ao kernel se o destino estiver dormindo
+bool ShmTransport::writeRecord(Segment* segment, uint32_t header, std::string_view payload) {
+    size_t ringBytes = segment->ringBytes;
+    size_t need = alignUp(sizeof(header) + payload.size(), RECORD_ALIGN);
+    RingHeader& ring = segment->ring(slot);
+    char* buffer = segment->ringData(slot);
+    uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+    size_t offset = tail & (ringBytes - 1);
+    size_t toEnd = ringBytes - offset;
+    size_t total = need + (toEnd < need ? toEnd : 0);
+
+    // Espera o destino liberar espaço: primeiro ativamente, depois cedendo a CPU, até o tempo limite
+    int spins = 0;
+    std::chrono::steady_clock::time_point deadline;
+    while (ringBytes - (tail - ring.head.load(std::memory_order_acquire)) < total) {
+        if (++spins < IDLE_SPINS) {
+            cpuRelax();
+            continue;
+        }
+        if (spins == IDLE_SPINS) deadline = std::chrono::steady_clock::now() + FULL_TIMEOUT;
+        else if (std::chrono::steady_clock::now() > deadline) return false;
+        std::this_thread::yield();
+    }
+
+    if (toEnd < need) {
+        std::memcpy(buffer + offset, &WRAP_MARKER, sizeof(uint32_t));
+        tail += toEnd;
+        offset = 0;
+    }
+    std::memcpy(buffer + offset, &header, sizeof(header));
+    std::memcpy(buffer + offset + sizeof(header), payload.data(), payload.size());
+    ring.tail.store(tail + need, std::memory_order_release);
+
+    segment->doorbell.fetch_add(1, std::memory_order_seq_cst);
+    if (segment->sleeping.load(std::memory_order_seq_cst)) futexWake(&segment->doorbell);
+    return true;
+}
+
+// Uma mensagem maior que metade do buffer é dividida em fragmentos, escritos em sequência sob o lock do destino,
+// então os fragmentos de um remetente nunca se intercalam com outras mensagens dele.
+// Se o envio falhar depois de algum fragmento escrito, o próximo envio começa com ABORT_MARKER, para que o destino descarte a mensagem incompleta
+bool ShmTransport::send(int port, std::string_view data) {
+    Peer* peer;
+    {
+        std::lock_guard<std::mutex> lock(peersMtx);
+        std::unique_ptr<Peer>& entry = peers[port];
+        if (!entry) entry = std::make_unique<Peer>();
+        peer = entry.get();
+    }
+    std::lock_guard<std::mutex> lock(peer->mtx);
+    if (!peer->segment) peer->segment = attach(port, peer->size);
+    Segment* segment = peer->segment;
+    if (!segment) return false;
+
+    // Cada registro ocupa no máximo metade do buffer, para que sempre caiba depois que o destino o esvaziar
+    size_t maxChunk = segment->ringBytes / 2 - RECORD_ALIGN;
+    if (peer->partialPending) {
+        if (!writeRecord(segment, ABORT_MARKER, {})) return false;
+        peer->partialPending = false;
+    }
+    while (data.size() > maxChunk) {
+        if (!writeRecord(segment, FRAGMENT_FLAG | static_cast<uint32_t>(maxChunk), data.substr(0, maxChunk))) return false;
+        peer->partialPending = true;
+        data.remove_prefix(maxChunk);
+    }
+    if (!writeRecord(segment, static_cast<uint32_t>(data.size()), data)) return false;
+    peer->partialPending = false;
+    return true;
+}
+
+// Recria o segmento da porta (descartando um de uma execução anterior) e varre os buffers em uso.
+// Cada mensagem é entregue ao handler apontando para o próprio buffer, e o espaço só é liberado depois da chamada.
+// Só as mensagens fragmentadas são copiadas, para um buffer por remetente onde os fragmentos são concatenados.
+// Sem mensagens, a thread marca "sleeping" e dorme no futex, a menos que o "doorbell" tenha mudado desde o início da varredura
+bool ShmTransport::listen(int port, const MessageHandler& handler) {
+    std::string name = segmentName(port);
+    shm_unlink(name.c_str());
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        perror("shm_open failed");
+        return false;
+    }
+    size_t size = segmentSize();
+    if (ftruncate(fd, static_cast<off_t>(size)) < 0) {
+        perror("ftruncate failed");
+        close(fd);
+        return false;
+    }
+    void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        perror("mmap failed");
+        return false;
+    }
+
+    Segment* segment = new (memory) Segment{};
+    segment->magic = SHM_MAGIC;
+    segment->version = SHM_VERSION;
+    segment->slots = slotCount();
+    segment->ringBytes = static_cast<uint32_t>(config.shmRingKb) * 1024;
+    segment->ready.store(1, std::memory_order_release);
+
+    const size_t ringBytes = segment->ringBytes;
+    std::atomic<uint64_t>* active = segment->active();
+    std::vector<std::string> partial(segment->slots);
+    int idle = 0;
+    while (true) {
+        uint32_t bell = segment->doorbell.load(std::memory_order_acquire);
+        bool received = false;
+        for (uint32_t w = 0; w < segment->activeWords(); ++w) {
+            uint64_t mask = active[w].load(std::memory_order_acquire);
+            while (mask) {
+                uint32_t from = w * 64 + __builtin_ctzll(mask);
+                mask &= mask - 1;
+                RingHeader& ring = segment->ring(from);
+                const char* buffer = segment->ringData(from);
+                uint64_t head = ring.head.load(std::memory_order_relaxed);
+                uint64_t tail = ring.tail.load(std::memory_order_acquire);
+                if (head != tail) received = true;
+                while (head != tail) {
+                    size_t offset = head & (ringBytes - 1);
+                    uint32_t length;
+                    std::memcpy(&length, buffer + offset, sizeof(length));
+                    uint32_t size = length & ~FRAGMENT_FLAG;
+                    if (length == WRAP_MARKER) {
+                        head += ringBytes - offset;
+                    } else if (length == ABORT_MARKER) {
+                        partial[from].clear();
+                        head += alignUp(sizeof(length), RECORD_ALIGN);
+                    } else if (size > ringBytes - offset - sizeof(length)) {
+                        LOG_WARN("[SHM] Registro inválido no buffer do remetente " << from << ". Descartando o conteúdo do buffer.");
+                        partial[from].clear();
+                        head = tail;
+                    } else {
+                        std::string_view chunk(buffer + offset + sizeof(length), size);
+                        if (length & FRAGMENT_FLAG) {
+                            partial[from].append(chunk);
+                        } else if (!partial[from].empty()) {
+                            partial[from].append(chunk);
+                            handler(partial[from]);
+                            partial[from].clear();
+                        } else {
+                            handler(chunk);
+                        }
+                        head += alignUp(sizeof(length) + size, RECORD_ALIGN);
+                    }
+                    ring.head.store(head, std::memory_order_release);
+                }
+            }
+        }
+        if (received) {
+            idle = 0;
+            continue;
+        }
+        if (++idle < IDLE_SPINS) {
+            cpuRelax();
+            continue;
+        }
+        segment->sleeping.store(1, std::memory_order_seq_cst);
+        if (segment->doorbell.load(std::memory_order_seq_cst) == bell) futexWait(&segment->doorbell, bell, 100000000);
+        segment->sleeping.store(0, std::memory_order_relaxed);
+        idle = 0;
+    }
+    return true;
+}
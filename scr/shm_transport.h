@@ -0,0 +1,70 @@
+#ifndef SHM_TRANSPORT_H
+#define SHM_TRANSPORT_H
+
+#include <string>
+#include <string_view>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+#include "config.h"
+#include "transport.h"
+
+
+// Transporte por memória compartilhada POSIX, para processos no mesmo host (configuração "transport=shm").
+// Cada participante que escuta em uma porta cria o segmento "/dphil-<porta>" com um buffer circular por remetente possível
+// (os filósofos e os fragmentos do coordenador). Cada buffer tem um único produtor (o processo remetente, com os envios das suas threads
+// serializados por um mutex) e um único consumidor (a thread de escuta do destino), então basta publicar as posições
+// de escrita e leitura com operações atômicas, sem locks entre os processos.
+// As mensagens são entregues ao handler diretamente do buffer circular, sem cópias nem chamadas ao kernel;
+// o consumidor só dorme (em um futex no segmento) quando todos os buffers estão vazios, e o produtor só o acorda nesse caso.
+// As mensagens maiores que metade do buffer são divididas em fragmentos e remontadas pelo destino (só elas são copiadas).
+//
+// Um destino reiniciado recria o seu segmento; os remetentes que já o tinham mapeado precisam ser reiniciados também.
+class ShmTransport : public Transport {
+public:
+    // "ownPort" é a porta do próprio participante, que identifica o seu buffer nos segmentos dos destinos
+    ShmTransport(const Config& config, int ownPort);
+    // Desfaz os mapeamentos dos segmentos
+    ~ShmTransport();
+
+    // Escreve a mensagem no buffer deste participante no segmento do destino, esperando por espaço se ele estiver cheio.
+    // Retorna falso se o destino ainda não criou o segmento ou se o buffer continuar cheio
+    bool send(int port, std::string_view data) override;
+    // Cria o segmento da porta e entrega as mensagens de todos os buffers a "handler". Não retorna se conseguir criar o segmento
+    bool listen(int port, const MessageHandler& handler) override;
+
+    struct Segment;
+
+private:
+    // Segmento mapeado de um destino e o mutex que serializa os envios das threads deste processo para ele
+    struct Peer {
+        std::mutex mtx;
+        Segment* segment = nullptr;
+        size_t size = 0;
+        // Algum fragmento de uma mensagem cujo envio falhou já foi escrito no buffer
+        bool partialPending = false;
+    };
+
+    Config config;
+    // Índice do buffer deste participante nos segmentos dos destinos
+    uint32_t slot;
+    // Protege apenas o mapa de destinos
+    std::mutex peersMtx;
+    std::map<int, std::unique_ptr<Peer>> peers;
+
+    // Índice do buffer do participante que escuta na porta especificada (os filósofos e, por último, os fragmentos do coordenador)
+    uint32_t slotOf(int port) const;
+    // Número de buffers e tamanho total de um segmento
+    uint32_t slotCount() const;
+    size_t segmentSize() const;
+    // Mapeia o segmento do destino, se ele já tiver sido criado e inicializado
+    Segment* attach(int port, size_t& size);
+    // Escreve um registro (palavra de tamanho ou marca, seguida do conteúdo) no buffer deste participante no segmento
+    bool writeRecord(Segment* segment, uint32_t header, std::string_view payload);
+};
+
+#endif
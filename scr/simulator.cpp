@@ -0,0 +1,266 @@
+// Simulação do sistema inteiro em um único processo, com um relógio virtual.
+// O Coordinator e todos os Philosopher executam a mesma lógica dos processos, mas trocam mensagens por canais em memória
+// em vez de TCP, e os tempos de pensar, comer, de rede e o intervalo dos snapshots avançam um relógio virtual em vez de esperas reais.
+// Todos os eventos (entregas de mensagens, fim das fases de pensar e comer, início das rodadas de snapshot) são processados
+// por uma única thread, em ordem de instante virtual e, em caso de empate, de criação. Com a mesma semente e as mesmas opções
+// a execução é idêntica, o que permite reproduzir um deadlock quantas vezes for preciso; a assinatura impressa ao final
+// resume a sequência de entregas e serve para comparar duas execuções.
+//
+// Uso: ./simulator [--sim_time_ms=10000] [--seed=1] [--latency_us=50] [--distribution=exp|fixed|uniform]
+//                  [opções do cluster, ex.: --philosophers=10000 --think_ms=5 --eat_ms=5 --snapshot_interval_ms=100 --log_level=warn]
+//
+// Os canais são FIFO, como o TCP: a latência de cada mensagem é sorteada, mas uma mensagem nunca é entregue antes
+// da anterior no mesmo canal (exigência do algoritmo de snapshot de Chandy-Lamport).
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "config.h"
+#include "coordinator.h"
+#include "philosopher.h"
+#include "transport.h"
+
+// Opções da simulação, separadas das opções do cluster
+struct SimOptions {
+    int simTimeMs = 10000;
+    uint64_t seed = 1;
+    int latencyUs = 50;
+    std::string distribution = "exp";
+};
+
+class Simulation {
+public:
+    Simulation(const Config& config, const SimOptions& options) : config(config), options(options), rng(options.seed) {
+        coordinatorNode = config.numPhilosophers;
+        lastNode = coordinatorNode + config.coordinatorShards - 1;
+        for (int node = 0; node <= lastNode; ++node) endpoints.push_back(std::make_unique<Endpoint>(*this, node));
+        for (int shard = 0; shard < config.coordinatorShards; ++shard)
+            coordinators.push_back(std::make_unique<Coordinator>(config, shard, endpoints[coordinatorNode + shard].get()));
+        for (int i = 0; i < config.numPhilosophers; ++i)
+            philosophers.push_back(std::make_unique<Philosopher>(i, config, endpoints[i].get()));
+        hungrySince.resize(config.numPhilosophers);
+    }
+
+    // Processa os eventos até o instante virtual final
+    void run() {
+        for (int i = 0; i < config.numPhilosophers; ++i) schedule(sample(config.thinkMs), EventKind::THINK_END, i);
+        schedule(msToNs(config.snapshotIntervalMs), EventKind::SNAPSHOT_TICK, coordinatorNode);
+
+        uint64_t endNs = msToNs(options.simTimeMs);
+        while (!events.empty() && events.front().at <= endNs) {
+            std::pop_heap(events.begin(), events.end(), laterThan);
+            Event event = std::move(events.back());
+            events.pop_back();
+            nowNs = event.at;
+
+            switch (event.kind) {
+            case EventKind::DELIVER:
+                deliver(event);
+                break;
+            case EventKind::THINK_END:
+                hungrySince[event.node] = nowNs;
+                philosophers[event.node]->becomeHungry();
+                break;
+            case EventKind::EAT_END:
+                philosophers[event.node]->finishEating();
+                ++meals;
+                lastMealNs = nowNs;
+                schedule(sample(config.thinkMs), EventKind::THINK_END, event.node);
+                break;
+            case EventKind::SNAPSHOT_TICK:
+                coordinators[0]->startSnapshotRound();
+                schedule(msToNs(config.snapshotIntervalMs), EventKind::SNAPSHOT_TICK, coordinatorNode);
+                break;
+            }
+        }
+        nowNs = std::max(nowNs, endNs);
+    }
+
+    // Imprime o tempo virtual e real, a vazão de mensagens, as refeições e a assinatura da execução
+    void report(double wallSeconds) {
+        double virtualSeconds = nowNs / 1e9;
+        std::cout << "Filósofos=" << config.numPhilosophers << ", semente=" << options.seed << ", distribuição=" << options.distribution
+                  << ", latência=" << options.latencyUs << "us\n";
+        std::cout << "Tempo virtual: " << virtualSeconds << "s, tempo real: " << wallSeconds << "s\n";
+        std::cout << "Mensagens entregues: " << delivered << " (" << delivered / std::max(wallSeconds, 1e-9) << "/s reais), descartadas: " << dropped << "\n";
+        std::cout << "Refeições: " << meals << " (" << meals / std::max(virtualSeconds, 1e-9) << "/s virtuais), última em " << lastMealNs / 1e6 << "ms\n";
+        if (!acquireNs.empty()) {
+            std::sort(acquireNs.begin(), acquireNs.end());
+            auto at = [&](double q) { return acquireNs[std::min(acquireNs.size() - 1, static_cast<size_t>(q * acquireNs.size()))] / 1e3; };
+            std::cout << "Tempo virtual para obter os dois garfos: p50=" << at(0.5) << "us p99=" << at(0.99) << "us max=" << acquireNs.back() / 1e3 << "us\n";
+        }
+        char signature[17];
+        std::snprintf(signature, sizeof(signature), "%016llx", static_cast<unsigned long long>(hash));
+        std::cout << "Assinatura da execução: " << signature << "\n";
+    }
+
+private:
+    enum class EventKind : uint8_t {
+        DELIVER,
+        THINK_END,
+        EAT_END,
+        SNAPSHOT_TICK
+    };
+
+    // Evento agendado no relógio virtual. "sequence" desempata eventos no mesmo instante pela ordem de criação
+    struct Event {
+        uint64_t at;
+        uint64_t sequence;
+        EventKind kind;
+        // Destino do evento: filósofo ou fragmento do coordenador (numPhilosophers + fragmento)
+        int node;
+        // Remetente e mensagem codificada, para as entregas
+        int from = -1;
+        std::string data;
+    };
+
+    // Transporte de um participante: registra o remetente para que cada par (remetente, destino) seja um canal FIFO
+    class Endpoint : public Transport {
+    public:
+        Endpoint(Simulation& simulation, int node) : simulation(simulation), node(node) {}
+        bool send(int port, std::string_view data) override { return simulation.post(node, port, data); }
+        // As mensagens são entregues pelo laço de eventos da simulação, e não por uma thread de escuta
+        bool listen(int, const MessageHandler&) override { return false; }
+
+    private:
+        Simulation& simulation;
+        int node;
+    };
+
+    Config config;
+    SimOptions options;
+    std::mt19937_64 rng;
+    // Nós dos fragmentos do coordenador: de coordinatorNode (o fragmento 0, que inicia os snapshots) a lastNode
+    int coordinatorNode;
+    int lastNode;
+    std::vector<std::unique_ptr<Endpoint>> endpoints;
+    std::vector<std::unique_ptr<Coordinator>> coordinators;
+    std::vector<std::unique_ptr<Philosopher>> philosophers;
+
+    // Relógio virtual, em nanossegundos
+    uint64_t nowNs = 0;
+    uint64_t nextSequence = 0;
+    // Heap de eventos, com o mais próximo na frente
+    std::vector<Event> events;
+    // Instante da última entrega agendada em cada canal (remetente, destino), para manter a ordem FIFO
+    std::unordered_map<uint64_t, uint64_t> channelTail;
+
+    std::vector<uint64_t> hungrySince;
+    std::vector<uint64_t> acquireNs;
+    uint64_t delivered = 0;
+    uint64_t dropped = 0;
+    uint64_t meals = 0;
+    uint64_t lastMealNs = 0;
+    // Assinatura FNV-1a da sequência de entregas (instante, remetente, destino e conteúdo)
+    uint64_t hash = 1469598103934665603ULL;
+
+    static bool laterThan(const Event& a, const Event& b) {
+        return a.at != b.at ? a.at > b.at : a.sequence > b.sequence;
+    }
+
+    static uint64_t msToNs(int ms) { return static_cast<uint64_t>(ms) * 1000000; }
+
+    void push(Event event) {
+        event.sequence = nextSequence++;
+        events.push_back(std::move(event));
+        std::push_heap(events.begin(), events.end(), laterThan);
+    }
+
+    void schedule(uint64_t delayNs, EventKind kind, int node) {
+        push(Event{ nowNs + delayNs, 0, kind, node });
+    }
+
+    // Sorteia a duração de uma fase com média "meanMs"
+    uint64_t sample(int meanMs) {
+        double ms = meanMs;
+        if (options.distribution == "exp" && meanMs > 0) ms = std::exponential_distribution<double>(1.0 / meanMs)(rng);
+        else if (options.distribution == "uniform") ms = std::uniform_real_distribution<double>(0, 2.0 * meanMs)(rng);
+        return static_cast<uint64_t>(ms * 1e6);
+    }
+
+    // Agenda a entrega da mensagem com uma latência entre metade e uma vez e meia "latency_us", sem ultrapassar a anterior do mesmo canal
+    bool post(int from, int port, std::string_view data) {
+        int shardOffset = port - config.coordinatorPort;
+        int to = shardOffset >= 0 && shardOffset < config.coordinatorShards ? coordinatorNode + shardOffset : port - config.basePort;
+        if (to < 0 || to > lastNode) {
+            ++dropped;
+            return false;
+        }
+        uint64_t latencyNs = static_cast<uint64_t>(options.latencyUs) * 1000;
+        uint64_t at = nowNs + latencyNs / 2 + (latencyNs > 0 ? rng() % latencyNs : 0);
+        uint64_t& tail = channelTail[static_cast<uint64_t>(from) << 32 | static_cast<uint32_t>(to)];
+        at = std::max(at, tail);
+        tail = at;
+        push(Event{ at, 0, EventKind::DELIVER, to, from, std::string(data) });
+        return true;
+    }
+
+    void mix(const void* data, size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) hash = (hash ^ bytes[i]) * 1099511628211ULL;
+    }
+
+    // Entrega a mensagem ao destino. Depois de cada mensagem recebida por um filósofo faminto, verifica se ele já pode comer
+    void deliver(const Event& event) {
+        ++delivered;
+        mix(&event.at, sizeof(event.at));
+        mix(&event.from, sizeof(event.from));
+        mix(&event.node, sizeof(event.node));
+        mix(event.data.data(), event.data.size());
+
+        if (event.node >= coordinatorNode) {
+            coordinators[event.node - coordinatorNode]->dispatch(event.data);
+            return;
+        }
+        Philosopher& philosopher = *philosophers[event.node];
+        philosopher.handleMessage(event.data);
+        if (philosopher.tryStartEating()) {
+            acquireNs.push_back(nowNs - hungrySince[event.node]);
+            schedule(sample(config.eatMs), EventKind::EAT_END, event.node);
+        }
+    }
+};
+
+int main(int argc, char* argv[]) {
+    // Separa as opções da simulação das opções do cluster
+    SimOptions options;
+    std::vector<char*> clusterArgs{ argv[0] };
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--sim_time_ms=", 0) == 0) options.simTimeMs = std::atoi(arg.c_str() + 14);
+        else if (arg.rfind("--seed=", 0) == 0) options.seed = std::strtoull(arg.c_str() + 7, nullptr, 10);
+        else if (arg.rfind("--latency_us=", 0) == 0) options.latencyUs = std::atoi(arg.c_str() + 13);
+        else if (arg.rfind("--distribution=", 0) == 0) options.distribution = arg.substr(15);
+        else clusterArgs.push_back(argv[i]);
+    }
+    Config config;
+    std::vector<std::string> positional;
+    if (options.simTimeMs <= 0 || options.latencyUs < 0 ||
+        !Config::load(static_cast<int>(clusterArgs.size()), clusterArgs.data(), config, positional)) {
+        std::cerr << "Uso: " << argv[0] << " [--sim_time_ms=N] [--seed=N] [--latency_us=N] [--distribution=exp|fixed|uniform] [--chave=valor ...]\n";
+        return 1;
+    }
+    setLogLevel(config.logLevel);
+    // Os envios precisam acontecer na thread da simulação, na ordem dos eventos, para que a execução seja reproduzível.
+    // Cada filósofo é um nó da simulação, com a sua própria porta
+    config.sendThreads = 0;
+    config.philosophersPerProcess = 1;
+
+    auto start = std::chrono::steady_clock::now();
+    Simulation simulation(config, options);
+    simulation.run();
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    logFlush();
+    simulation.report(wallSeconds);
+    // Os histogramas de tempo das métricas medem o tempo real de processamento, e não o relógio virtual
+    std::cout << "Métricas:\n" << metricsReport() << std::flush;
+    return 0;
+}
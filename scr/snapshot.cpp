@@ -1,58 +1,205 @@
 #include "snapshot.h"
-// Converte todos os campos do snapshot (estado local, posse de garfos, IDs de garfos e mensagens em trânsito) em um formato de string que pode ser facilmente transmitido e posteriormente deserializado.
-std::string Snapshot::serialize() const {
-    std::ostringstream oss;
-    oss << "state=" << localState;
-    oss << ";hasLeft=" << (hasLeftFork ? "true" : "false");
-    oss << ";hasRight=" << (hasRightFork ? "true" : "false");
-    oss << ";leftForkId=" << leftForkId;
-    oss << ";rightForkId=" << rightForkId;
 
+#include "wire.h"
+
+// Tamanho do cabeçalho fixo: versão(1) + estado(1) + flags(1) + reservado(1) + garfo esquerdo(4) + garfo direito(4) + número de canais(4)
+static const size_t SNAPSHOT_HEADER_SIZE = 16;
+// Tamanho do estado local dentro do cabeçalho, antes do número de canais
+static const size_t LOCAL_STATE_SIZE = 12;
+// Bits do campo "flags"
+static const uint8_t FLAG_HAS_LEFT = 0x1;
+static const uint8_t FLAG_HAS_RIGHT = 0x2;
+
+// Tamanho dos canais codificados, sem o contador de canais
+static size_t channelsSize(const std::map<int, std::vector<Message>>& channelMessages) {
+    size_t total = 0;
     for (const auto& [from, msgs] : channelMessages) {
-        for (const std::string& msg : msgs) {
-            oss << ";channel_from_" << from << "_msg_" << msg;
+        total += 8;
+        for (const Message& msg : msgs) total += 4 + msg.encodedSize();
+    }
+    return total;
+}
+
+// Grava o contador de canais seguido de cada canal
+static void putChannels(char*& p, const std::map<int, std::vector<Message>>& channelMessages) {
+    putU32(p, static_cast<uint32_t>(channelMessages.size()));
+    for (const auto& [from, msgs] : channelMessages) {
+        putI32(p, from);
+        putU32(p, static_cast<uint32_t>(msgs.size()));
+        for (const Message& msg : msgs) {
+            putU32(p, static_cast<uint32_t>(msg.encodedSize()));
+            p += msg.encode(p);
         }
     }
-    return oss.str();
-}
-
-// Inverte o processo de serialização, analisando a string de entrada para reconstruir o objeto Snapshot, preenchendo seus campos com os valores extraídos. 
-// Lida com a formatação específica das mensagens em trânsito.
-Snapshot Snapshot::deserialize(const std::string& data) {
-    Snapshot snap;
-    std::string token;
-    std::istringstream iss(data);
-
-    while (std::getline(iss, token, ';')) {
-        size_t eqPos = token.find('=');
-        if (eqPos == std::string::npos) { // Pode ser um campo de mensagem sem '=' diretamente
-            size_t fromPos = token.find("channel_from_");
-            if (fromPos != std::string::npos) {
-                std::string rest = token.substr(fromPos + strlen("channel_from_"));
-                size_t msgPos = rest.find("_msg_");
-                if (msgPos != std::string::npos) {
-                    int senderId = std::stoi(rest.substr(0, msgPos));
-                    std::string msgContent = rest.substr(msgPos + strlen("_msg_"));
-                    snap.channelMessages[senderId].push_back(msgContent);
-                }
-            }
-            continue;
+}
+
+// Lê o contador de canais seguido de cada canal, validando cada tamanho antes de ler
+static bool getChannels(const char*& p, const char* end, std::map<int, std::vector<Message>>& channelMessages) {
+    channelMessages.clear();
+    if (end - p < 4) return false;
+    uint32_t channels = getU32(p);
+    for (uint32_t c = 0; c < channels; ++c) {
+        if (end - p < 8) return false;
+        int from = getI32(p);
+        uint32_t count = getU32(p);
+        std::vector<Message>& msgs = channelMessages[from];
+        for (uint32_t m = 0; m < count; ++m) {
+            if (end - p < 4) return false;
+            uint32_t size = getU32(p);
+            if (static_cast<size_t>(end - p) < size) return false;
+            Message msg;
+            if (!Message::decode(std::string_view(p, size), msg)) return false;
+            msgs.push_back(std::move(msg));
+            p += size;
         }
+    }
+    return true;
+}
 
-        std::string key = token.substr(0, eqPos);
-        std::string value = token.substr(eqPos + 1);
-
-        if (key == "state") {
-            snap.localState = value;
-        } else if (key == "hasLeft") {
-            snap.hasLeftFork = (value == "true");
-        } else if (key == "hasRight") {
-            snap.hasRightFork = (value == "true");
-        } else if (key == "leftForkId") {
-            snap.leftForkId = std::stoi(value);
-        } else if (key == "rightForkId") {
-            snap.rightForkId = std::stoi(value);
+// Lê o contador de canais seguido de cada canal para os vetores da arena. As mensagens são decodificadas sem cópias.
+// Os contadores são comparados com os bytes restantes antes de alocar, para que dados inválidos não causem alocações enormes
+static bool getChannelViews(const char*& p, const char* end, SnapshotView& snap, Arena& arena) {
+    if (end - p < 4) return false;
+    uint32_t channels = getU32(p);
+    if (channels > static_cast<size_t>(end - p) / 8) return false;
+    SnapshotView::Channel* out = arena.allocateArray<SnapshotView::Channel>(channels);
+    for (uint32_t c = 0; c < channels; ++c) {
+        if (end - p < 8) return false;
+        int from = getI32(p);
+        uint32_t count = getU32(p);
+        if (count > static_cast<size_t>(end - p) / (4 + MESSAGE_HEADER_SIZE)) return false;
+        MessageView* msgs = arena.allocateArray<MessageView>(count);
+        for (uint32_t m = 0; m < count; ++m) {
+            if (end - p < 4) return false;
+            uint32_t size = getU32(p);
+            if (static_cast<size_t>(end - p) < size) return false;
+            if (!MessageView::decode(std::string_view(p, size), msgs[m])) return false;
+            p += size;
         }
+        out[c] = { from, msgs, count };
+    }
+    snap.channels = out;
+    snap.channelCount = channels;
+    return true;
+}
+
+// Lê o estado local comum a Snapshot e SnapshotView: estado, posse e IDs dos garfos
+template <typename SnapshotType>
+static bool getLocalState(const char*& p, const char* end, SnapshotType& snap) {
+    if (end - p < static_cast<ptrdiff_t>(LOCAL_STATE_SIZE)) return false;
+    if (getU8(p) != SNAPSHOT_VERSION) return false;
+    uint8_t state = getU8(p);
+    if (state > static_cast<uint8_t>(PhilosopherState::EATING)) return false;
+    snap.localState = static_cast<PhilosopherState>(state);
+    uint8_t flags = getU8(p);
+    snap.hasLeftFork = flags & FLAG_HAS_LEFT;
+    snap.hasRightFork = flags & FLAG_HAS_RIGHT;
+    getU8(p);
+    snap.leftForkId = getI32(p);
+    snap.rightForkId = getI32(p);
+    return true;
+}
+
+// Regras de interpretação das mensagens em trânsito de um canal, para Snapshot e SnapshotView
+template <typename Messages>
+static bool grantIn(const Messages& msgs, int forkId, int leftForkId, int rightForkId) {
+    for (const auto& m : msgs) {
+        if (m.type == MessageType::FORK_GRANTED && m.forkId == forkId) return true;
+        if (m.type == MessageType::PAIR_GRANTED && (forkId == leftForkId || forkId == rightForkId)) return true;
+    }
+    return false;
+}
+
+template <typename Messages>
+static bool revokeIn(const Messages& msgs, int forkId) {
+    for (const auto& m : msgs) {
+        if (m.type == MessageType::PREEMPT && m.forkId == forkId) return true;
+    }
+    return false;
+}
+
+bool Snapshot::grantedInTransit(int channel, int forkId) const {
+    auto it = channelMessages.find(channel);
+    return it != channelMessages.end() && grantIn(it->second, forkId, leftForkId, rightForkId);
+}
+
+bool Snapshot::holdsFork(int channel, int forkId) const {
+    bool held = (forkId == leftForkId && hasLeftFork) || (forkId == rightForkId && hasRightFork);
+    if (!held) return false;
+    auto it = channelMessages.find(channel);
+    return it == channelMessages.end() || !revokeIn(it->second, forkId);
+}
+
+// Os snapshots têm poucos canais (os vizinhos e os fragmentos do coordenador), então a busca é linear
+bool SnapshotView::grantedInTransit(int channel, int forkId) const {
+    for (const Channel& c : *this) {
+        if (c.from == channel) return grantIn(c, forkId, leftForkId, rightForkId);
+    }
+    return false;
+}
+
+bool SnapshotView::holdsFork(int channel, int forkId) const {
+    bool held = (forkId == leftForkId && hasLeftFork) || (forkId == rightForkId && hasRightFork);
+    if (!held) return false;
+    for (const Channel& c : *this) {
+        if (c.from == channel) return !revokeIn(c, forkId);
+    }
+    return true;
+}
+
+bool SnapshotView::decode(std::string_view data, SnapshotView& snap, Arena& arena) {
+    const char* p = data.data();
+    const char* end = data.data() + data.size();
+    snap.channels = nullptr;
+    snap.channelCount = 0;
+    if (!getLocalState(p, end, snap)) return false;
+    if (!getChannelViews(p, end, snap, arena)) return false;
+    return p == end;
+}
+
+bool SnapshotView::decodeLocalState(std::string_view data, SnapshotView& snap) {
+    const char* p = data.data();
+    snap.channels = nullptr;
+    snap.channelCount = 0;
+    return getLocalState(p, data.data() + data.size(), snap);
+}
+
+const char* stateName(PhilosopherState state) {
+    switch (state) {
+        case PhilosopherState::THINKING: return "thinking";
+        case PhilosopherState::HUNGRY: return "hungry";
+        case PhilosopherState::EATING: return "eating";
     }
-    return snap;
-}
\ No newline at end of file
+    return "unknown";
+}
+
+bool Snapshot::sameLocalState(const Snapshot& other) const {
+    return localState == other.localState && hasLeftFork == other.hasLeftFork && hasRightFork == other.hasRightFork;
+}
+
+// Converte todos os campos do snapshot (estado local, posse de garfos, IDs de garfos e mensagens em trânsito) em um layout binário fixo.
+// Cada canal é gravado como: remetente(4) + quantidade de mensagens(4), seguido de cada mensagem como tamanho(4) + mensagem codificada.
+// O tamanho total é calculado antes, para que a string seja alocada uma única vez.
+std::string Snapshot::serialize() const {
+    std::string data(SNAPSHOT_HEADER_SIZE + channelsSize(channelMessages), '\0');
+    char* p = data.data();
+    putU8(p, SNAPSHOT_VERSION);
+    putU8(p, static_cast<uint8_t>(localState));
+    putU8(p, (hasLeftFork ? FLAG_HAS_LEFT : 0) | (hasRightFork ? FLAG_HAS_RIGHT : 0));
+    putU8(p, 0);
+    putI32(p, leftForkId);
+    putI32(p, rightForkId);
+    putChannels(p, channelMessages);
+    return data;
+}
+
+// Inverte o processo de serialização, validando cada tamanho antes de ler para não ultrapassar o fim dos dados.
+// As mensagens em trânsito são decodificadas diretamente para a lista do canal correspondente.
+bool Snapshot::decode(std::string_view data, Snapshot& snap) {
+    const char* p = data.data();
+    const char* end = data.data() + data.size();
+    snap.channelMessages.clear();
+    if (!getLocalState(p, end, snap)) return false;
+    if (!getChannels(p, end, snap.channelMessages)) return false;
+    return p == end;
+}
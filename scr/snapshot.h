@@ -2,30 +2,90 @@
 #define SNAPSHOT_H
 
 #include <string>
+#include <string_view>
 #include <map>
 #include <vector>
-#include <sstream>
-#include <iostream> // Para debugging
-#include <cstring> // Para strlen
+#include <cstdint>
 
-#include "message.h" // Incluir para deserializar mensagens em transito no deserialize do snapshot (apenas para debug se precisar)
+#include "message.h" // As mensagens em trânsito são guardadas já decodificadas dentro do snapshot
+#include "arena.h"
 
 
+// Estado local de um filósofo
+enum class PhilosopherState : uint8_t {
+    THINKING,
+    HUNGRY,
+    EATING
+};
+
+// Retorna o nome do estado ("thinking", "hungry" ou "eating"), para impressão
+const char* stateName(PhilosopherState state);
+
+// Versão do formato binário do snapshot
+const uint8_t SNAPSHOT_VERSION = 1;
+
 // Estrutura usada para coletar o estado global do sistema em um determinado instante de tempo
 // Cada filósofo registra seu estado local e as mensagens que estavam em trânsito em seus canais de entrada no momento que recebream a mensagem "MARKERr" do coordenador
 struct Snapshot {
-    std::string localState;
-    std::map<int, std::vector<std::string>> channelMessages;
+    PhilosopherState localState = PhilosopherState::THINKING;
+    // Mensagens em trânsito, agrupadas pelo remetente (canal de entrada)
+    std::map<int, std::vector<Message>> channelMessages;
     // Adicionado para a detecção de deadlock
     bool hasLeftFork = false;
     bool hasRightFork = false;
-    int leftForkId; // Adicionar o ID do garfo esquerdo
-    int rightForkId; // Adicionar o ID do garfo direito
+    int leftForkId = -1; // ID do garfo esquerdo
+    int rightForkId = -1; // ID do garfo direito
 
-    // Serializa a estrutura de snapshot para a transmissão pela rede
+    // Verifica se a concessão do garfo (um FORK_GRANTED do garfo ou um PAIR_GRANTED, que concede os dois garfos do filósofo)
+    // está entre as mensagens em trânsito do canal especificado
+    bool grantedInTransit(int channel, int forkId) const;
+
+    // Verifica se o filósofo possuía o garfo no corte: pelo estado local, desde que a revogação do garfo (PREEMPT)
+    // não esteja entre as mensagens em trânsito do canal especificado
+    bool holdsFork(int channel, int forkId) const;
+
+    // Verifica se o estado local e a posse dos garfos são os mesmos do outro snapshot (sem comparar as mensagens em trânsito)
+    bool sameLocalState(const Snapshot& other) const;
+
+    // Serializa a estrutura de snapshot no formato binário para a transmissão pela rede
     std::string serialize() const;
-    // Deserializa a string em na estrutura de Snapshot
-    static Snapshot deserialize(const std::string& data);
+    // Decodifica o formato binário na estrutura de Snapshot. Retorna falso se os dados forem inválidos
+    static bool decode(std::string_view data, Snapshot& snap);
+};
+
+// Snapshot decodificado em uma arena, sem estruturas com nós nem cópias das mensagens: os canais e as mensagens em trânsito
+// ficam em vetores contíguos da arena e o conteúdo das mensagens aponta para os dados recebidos (também guardados na arena).
+// Usado pelo coordenador, que libera todos os snapshots de uma rodada de uma vez ao reiniciar a arena
+struct SnapshotView {
+    // Mensagens em trânsito de um canal de entrada
+    struct Channel {
+        int32_t from;
+        const MessageView* messages;
+        uint32_t count;
+
+        const MessageView* begin() const { return messages; }
+        const MessageView* end() const { return messages + count; }
+    };
+
+    PhilosopherState localState = PhilosopherState::THINKING;
+    bool hasLeftFork = false;
+    bool hasRightFork = false;
+    int32_t leftForkId = -1;
+    int32_t rightForkId = -1;
+    const Channel* channels = nullptr;
+    uint32_t channelCount = 0;
+
+    const Channel* begin() const { return channels; }
+    const Channel* end() const { return channels + channelCount; }
+    // Mesmas regras de Snapshot::grantedInTransit e Snapshot::holdsFork
+    bool grantedInTransit(int channel, int forkId) const;
+    bool holdsFork(int channel, int forkId) const;
+
+    // Decodifica o formato binário de Snapshot::serialize. "data" precisa continuar válido enquanto o snapshot for usado,
+    // e os vetores são alocados em "arena". Retorna falso se os dados forem inválidos
+    static bool decode(std::string_view data, SnapshotView& snap, Arena& arena);
+    // Decodifica apenas o estado local, a posse e os IDs dos garfos, sem os canais (que ficam vazios)
+    static bool decodeLocalState(std::string_view data, SnapshotView& snap);
 };
 
-#endif
\ No newline at end of file
+#endif
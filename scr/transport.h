@@ -0,0 +1,25 @@
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <string_view>
+#include <functional>
+
+
+// Meio pelo qual um participante (filósofo ou coordenador) troca mensagens já codificadas com os demais, identificados pela porta.
+// Implementações: TCP (ConnectionPool nos filósofos, Reactor no coordenador), buffers circulares em memória compartilhada
+// entre processos do mesmo host (ShmTransport, configuração "transport=shm") e os canais em memória do simulador.
+class Transport {
+public:
+    // Função chamada para cada mensagem recebida. A "string_view" só é válida durante a chamada
+    using MessageHandler = std::function<void(std::string_view)>;
+
+    virtual ~Transport() = default;
+
+    // Envia a mensagem para o participante que escuta na porta especificada. Retorna falso se não foi possível enviar
+    virtual bool send(int port, std::string_view data) = 0;
+    // Recebe as mensagens destinadas à porta especificada e as entrega a "handler", na thread atual.
+    // Bloqueia enquanto estiver recebendo; retorna falso se não foi possível escutar na porta
+    virtual bool listen(int port, const MessageHandler& handler) = 0;
+};
+
+#endif
@@ -0,0 +1,111 @@
+#include "wait_for_graph.h"
+
+#include <algorithm>
+
+WaitForGraph::WaitForGraph(int numPhilosophers, int numForks)
+    : waitingOn(numPhilosophers),
+      waitersOf(numForks),
+      holder(numForks, -1),
+      visitedStamp(numPhilosophers, 0),
+      parent(numPhilosophers, -1) {}
+
+void WaitForGraph::setDeadlockHandler(DeadlockHandler handler) {
+    std::lock_guard<std::mutex> lock(mtx);
+    this->handler = std::move(handler);
+}
+
+// Adiciona a aresta filósofo -> dono. Só essa aresta é nova, então só pode existir um ciclo novo
+// se o dono já alcança o filósofo pelas arestas existentes.
+void WaitForGraph::addWait(int philosopherId, int forkId, int32_t owner) {
+    std::lock_guard<std::mutex> lock(mtx);
+    std::vector<int>& forksWaited = waitingOn[philosopherId];
+    if (std::find(forksWaited.begin(), forksWaited.end(), forkId) == forksWaited.end()) {
+        forksWaited.push_back(forkId);
+        waitersOf[forkId].push_back(philosopherId);
+    }
+    holder[forkId] = owner;
+    if (owner < 0 || owner == philosopherId) return;
+
+    std::vector<int> path = searchPath(owner, [philosopherId](int node) { return node == philosopherId; });
+    if (!path.empty()) report(path);
+}
+
+// Remove a espera do novo dono pelo garfo e redireciona as arestas dos demais filósofos da fila para ele.
+// Um ciclo novo só pode passar pelo novo dono, então basta verificar se ele alcança algum filósofo da fila.
+void WaitForGraph::handOff(int forkId, int32_t newOwner) {
+    std::lock_guard<std::mutex> lock(mtx);
+    holder[forkId] = newOwner;
+    if (newOwner < 0) return;
+
+    std::vector<int>& forksWaited = waitingOn[newOwner];
+    forksWaited.erase(std::remove(forksWaited.begin(), forksWaited.end(), forkId), forksWaited.end());
+    std::vector<int>& waiters = waitersOf[forkId];
+    waiters.erase(std::remove(waiters.begin(), waiters.end(), newOwner), waiters.end());
+    if (waiters.empty()) return;
+
+    std::vector<int> path = searchPath(newOwner, [&waiters](int node) {
+        return std::find(waiters.begin(), waiters.end(), node) != waiters.end();
+    });
+    if (!path.empty()) report(path);
+}
+
+std::vector<int> WaitForGraph::findCycle() {
+    std::lock_guard<std::mutex> lock(mtx);
+    for (int node = 0; node < static_cast<int>(waitingOn.size()); ++node) {
+        if (waitingOn[node].empty()) continue;
+        std::vector<int> path = searchPath(node, [&](int other) {
+            if (other == node) return false;
+            for (int forkId : waitingOn[other]) {
+                if (holder[forkId] == node) return true;
+            }
+            return false;
+        });
+        if (!path.empty()) return path;
+    }
+    return {};
+}
+
+size_t WaitForGraph::edgeCount() {
+    std::lock_guard<std::mutex> lock(mtx);
+    size_t edges = 0;
+    for (const std::vector<int>& forksWaited : waitingOn) edges += forksWaited.size();
+    return edges;
+}
+
+// Cada filósofo tem no máximo algumas arestas de saída (um por garfo esperado), obtidas a partir do dono de cada garfo.
+// Os visitados são marcados com um contador de rodada, para não precisar limpar o vetor a cada busca.
+std::vector<int> WaitForGraph::searchPath(int from, const std::function<bool(int)>& isTarget) {
+    if (++stamp == 0) {
+        std::fill(visitedStamp.begin(), visitedStamp.end(), 0);
+        stamp = 1;
+    }
+
+    stack.clear();
+    stack.push_back(from);
+    visitedStamp[from] = stamp;
+    parent[from] = -1;
+
+    while (!stack.empty()) {
+        int node = stack.back();
+        stack.pop_back();
+        if (isTarget(node)) {
+            std::vector<int> path;
+            for (int current = node; current != -1; current = parent[current]) path.push_back(current);
+            std::reverse(path.begin(), path.end());
+            return path;
+        }
+        for (int forkId : waitingOn[node]) {
+            int32_t next = holder[forkId];
+            if (next < 0 || visitedStamp[next] == stamp) continue;
+            visitedStamp[next] = stamp;
+            parent[next] = node;
+            stack.push_back(next);
+        }
+    }
+    return {};
+}
+
+// O caminho encontrado vai do início da busca até o filósofo que espera por ele, fechando o ciclo
+void WaitForGraph::report(const std::vector<int>& cycle) {
+    if (handler) handler(cycle);
+}
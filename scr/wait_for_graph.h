@@ -0,0 +1,57 @@
+#ifndef WAIT_FOR_GRAPH_H
+#define WAIT_FOR_GRAPH_H
+
+#include <vector>
+#include <mutex>
+#include <functional>
+#include <cstdint>
+
+
+// Grafo de espera mantido incrementalmente pelo coordenador a partir das filas de garfos.
+// Um filósofo na fila de um garfo espera pelo dono atual desse garfo (aresta filósofo -> dono).
+// As arestas são atualizadas quando um filósofo entra na fila e quando um garfo é passado adiante,
+// e a cada atualização é verificado apenas se a mudança fechou um ciclo, sem reconstruir o grafo.
+// Assim um deadlock é detectado assim que o último pedido que o forma chega ao coordenador.
+class WaitForGraph {
+public:
+    // Função chamada quando um ciclo é detectado, com os filósofos que formam o ciclo (na ordem das arestas)
+    using DeadlockHandler = std::function<void(const std::vector<int>& cycle)>;
+
+    // Cria o grafo para "numPhilosophers" filósofos e "numForks" garfos
+    WaitForGraph(int numPhilosophers, int numForks);
+
+    // Define a função chamada quando um ciclo é detectado
+    void setDeadlockHandler(DeadlockHandler handler);
+    // O filósofo entrou na fila do garfo, que pertence a "owner" (ou a ninguém, se negativo)
+    void addWait(int philosopherId, int forkId, int32_t owner);
+    // O garfo foi passado da fila para "newOwner". Os demais filósofos na fila passam a esperar por ele
+    void handOff(int forkId, int32_t newOwner);
+    // Procura um ciclo no grafo inteiro. Retorna os filósofos do ciclo, ou um vetor vazio se não houver
+    std::vector<int> findCycle();
+    // Retorna o número de arestas de espera atuais
+    size_t edgeCount();
+
+private:
+    std::mutex mtx;
+    DeadlockHandler handler;
+    // Garfos pelos quais cada filósofo espera
+    std::vector<std::vector<int>> waitingOn;
+    // Filósofos na fila de cada garfo
+    std::vector<std::vector<int>> waitersOf;
+    // Dono de cada garfo que possui fila, do ponto de vista do grafo
+    std::vector<int32_t> holder;
+
+    // Área de trabalho da busca, reaproveitada entre as chamadas
+    std::vector<uint32_t> visitedStamp;
+    uint32_t stamp = 0;
+    std::vector<int> parent;
+    std::vector<int> stack;
+
+    // Busca em profundidade (iterativa) a partir de "from", parando no primeiro filósofo para o qual "isTarget" é verdadeiro.
+    // Retorna o caminho de "from" até o alvo, ou um vetor vazio se nenhum alvo for alcançável
+    std::vector<int> searchPath(int from, const std::function<bool(int)>& isTarget);
+    // Com o lock adquirido, notifica o ciclo encontrado
+    void report(const std::vector<int>& cycle);
+};
+
+#endif
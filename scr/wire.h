@@ -0,0 +1,57 @@
+#ifndef WIRE_H
+#define WIRE_H
+
+#include <cstdint>
+#include <cstring>
+
+// Funções auxiliares do formato binário das mensagens e snapshots.
+// Todos os inteiros são gravados em little-endian, independentemente da arquitetura.
+
+inline void putU8(char*& out, uint8_t value) {
+    *out++ = static_cast<char>(value);
+}
+
+inline void putU16(char*& out, uint16_t value) {
+    out[0] = static_cast<char>(value & 0xFF);
+    out[1] = static_cast<char>((value >> 8) & 0xFF);
+    out += 2;
+}
+
+inline void putU32(char*& out, uint32_t value) {
+    out[0] = static_cast<char>(value & 0xFF);
+    out[1] = static_cast<char>((value >> 8) & 0xFF);
+    out[2] = static_cast<char>((value >> 16) & 0xFF);
+    out[3] = static_cast<char>((value >> 24) & 0xFF);
+    out += 4;
+}
+
+inline void putI32(char*& out, int32_t value) {
+    putU32(out, static_cast<uint32_t>(value));
+}
+
+inline void putBytes(char*& out, const char* data, size_t size) {
+    std::memcpy(out, data, size);
+    out += size;
+}
+
+inline uint8_t getU8(const char*& in) {
+    return static_cast<uint8_t>(*in++);
+}
+
+inline uint16_t getU16(const char*& in) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(in);
+    in += 2;
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+inline uint32_t getU32(const char*& in) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(in);
+    in += 4;
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+inline int32_t getI32(const char*& in) {
+    return static_cast<int32_t>(getU32(in));
+}
+
+#endif